@@ -1,9 +1,31 @@
 #ifndef TIME_H
 #define TIME_H
 
-struct Time {
-    int hour;
-    int minute;
+#include <cstdint>
+
+// Время суток в минутах от полуночи (0..1439): сравнение — одна целочисленная
+// операция, часы и минуты выделяются только для вывода.
+class TimeOfDay {
+private:
+    std::uint16_t minutes;
+
+public:
+    constexpr TimeOfDay() : minutes(0) {}
+    constexpr explicit TimeOfDay(int _minutes) : minutes(static_cast<std::uint16_t>(_minutes)) {}
+    constexpr TimeOfDay(int _hour, int _minute) : minutes(static_cast<std::uint16_t>(_hour * 60 + _minute)) {}
+
+    constexpr int totalMinutes() const { return minutes; }
+    constexpr int hour() const { return minutes / 60; }
+    constexpr int minute() const { return minutes % 60; }
+
+    friend constexpr bool operator==(TimeOfDay a, TimeOfDay b) { return a.minutes == b.minutes; }
+    friend constexpr bool operator!=(TimeOfDay a, TimeOfDay b) { return a.minutes != b.minutes; }
+    friend constexpr bool operator<(TimeOfDay a, TimeOfDay b) { return a.minutes < b.minutes; }
+    friend constexpr bool operator<=(TimeOfDay a, TimeOfDay b) { return a.minutes <= b.minutes; }
+    friend constexpr bool operator>(TimeOfDay a, TimeOfDay b) { return a.minutes > b.minutes; }
+    friend constexpr bool operator>=(TimeOfDay a, TimeOfDay b) { return a.minutes >= b.minutes; }
 };
 
+static_assert(sizeof(TimeOfDay) == 2, "TimeOfDay должен занимать 16 бит");
+
 #endif // TIME_H
@@ -0,0 +1,668 @@
+#include "batch_runner.h"
+#include "booking_engine.h"
+#include "civil_date.h"
+#include "date_time_parser.h"
+#include "json_line.h"
+#include "sharded_engine.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+enum class BatchOp : uint8_t {
+    AddWorkstation,
+    DeleteWorkstation,
+    SetStatus,
+    AddBooking,
+    UpdateBooking,
+    CancelBooking,
+    PurgeExpired,
+    GetBooking,
+    ListWorkstations,
+    BookingsForDay,
+    IsFree
+};
+
+struct BatchOpName {
+    const char* name;
+    BatchOp op;
+};
+
+static const BatchOpName kBatchOps[] = {
+    { "add_workstation", BatchOp::AddWorkstation },
+    { "delete_workstation", BatchOp::DeleteWorkstation },
+    { "set_status", BatchOp::SetStatus },
+    { "add_booking", BatchOp::AddBooking },
+    { "update_booking", BatchOp::UpdateBooking },
+    { "cancel_booking", BatchOp::CancelBooking },
+    { "purge_expired", BatchOp::PurgeExpired },
+    { "get_booking", BatchOp::GetBooking },
+    { "list_workstations", BatchOp::ListWorkstations },
+    { "bookings_for_day", BatchOp::BookingsForDay },
+    { "is_free", BatchOp::IsFree },
+};
+
+// Команда, разобранная потоком чтения. Необязательные поля update_booking
+// отмечаются флагами has*: прежние значения известны только при выполнении.
+struct BatchCommand {
+    size_t line = 0;
+    const char* opName = nullptr; // nullptr — поле op не распознано
+    BatchOp op = BatchOp::PurgeExpired;
+    string error;                 // не пусто — команда не разобрана
+    int id = 0;
+    int workstationId = 0;
+    int rating = 0;
+    string name;                  // имя станции или клиента
+    WorkstationStatus status = WorkstationStatus::Available;
+    Date date;
+    TimeOfDay start;
+    TimeOfDay end;
+    bool hasWorkstation = false;
+    bool hasStatus = false;
+    bool hasDate = false;
+    bool hasStart = false;
+    bool hasEnd = false;
+};
+
+static bool parseCommand(const JsonLine& json, BatchCommand& cmd) {
+    string op;
+    if (!json.getString("op", op)) {
+        cmd.error = "нет строкового поля op";
+        return false;
+    }
+    for (const BatchOpName& entry : kBatchOps) {
+        if (op == entry.name) {
+            cmd.opName = entry.name;
+            cmd.op = entry.op;
+            break;
+        }
+    }
+    if (!cmd.opName) {
+        cmd.error = "неизвестная команда " + op;
+        return false;
+    }
+
+    auto requireInt = [&](const char* key, int& value) {
+        if (!json.getInt(key, value)) {
+            cmd.error = string("нужно целое поле ") + key;
+            return false;
+        }
+        return true;
+    };
+    auto optionalInt = [&](const char* key, int& value, bool& present) {
+        present = json.has(key);
+        return !present || requireInt(key, value);
+    };
+    auto requireName = [&](const char* key) {
+        if (!json.getString(key, cmd.name) || cmd.name.empty()) {
+            cmd.error = string("нужно непустое строковое поле ") + key;
+            return false;
+        }
+        return true;
+    };
+    auto optionalDate = [&](bool required) {
+        string text;
+        cmd.hasDate = json.getString("date", text);
+        if (!cmd.hasDate) {
+            if (required || json.has("date")) {
+                cmd.error = "нужно поле date (DD-MM-YYYY)";
+                return false;
+            }
+            return true;
+        }
+        if (!parseDate(text, cmd.date)) {
+            cmd.error = "неверная дата " + text;
+            return false;
+        }
+        return true;
+    };
+    auto optionalTime = [&](const char* key, TimeOfDay& value, bool& present, bool required) {
+        string text;
+        present = json.getString(key, text);
+        if (!present) {
+            if (required || json.has(key)) {
+                cmd.error = string("нужно поле ") + key + " (HH:MM)";
+                return false;
+            }
+            return true;
+        }
+        if (!parseTime(text, value)) {
+            cmd.error = "неверное время " + text;
+            return false;
+        }
+        return true;
+    };
+
+    switch (cmd.op) {
+        case BatchOp::AddWorkstation: {
+            bool hasRating;
+            if (!requireInt("id", cmd.id) || !requireName("name") || !optionalInt("rating", cmd.rating, hasRating)) {
+                return false;
+            }
+            if (cmd.rating < 0) {
+                cmd.error = "рейтинг не может быть отрицательным";
+                return false;
+            }
+            return true;
+        }
+        case BatchOp::DeleteWorkstation:
+        case BatchOp::CancelBooking:
+        case BatchOp::GetBooking:
+            return requireInt("id", cmd.id);
+        case BatchOp::SetStatus:
+        case BatchOp::ListWorkstations: {
+            string text;
+            if (cmd.op == BatchOp::SetStatus && !requireInt("id", cmd.id)) {
+                return false;
+            }
+            cmd.hasStatus = json.getString("status", text);
+            if (cmd.hasStatus ? !parseStatus(text, cmd.status) : cmd.op == BatchOp::SetStatus || json.has("status")) {
+                cmd.error = "нужно поле status: available, booked или maintenance";
+                return false;
+            }
+            return true;
+        }
+        case BatchOp::AddBooking:
+            return requireInt("id", cmd.id) && requireInt("workstation", cmd.workstationId) && requireName("client") &&
+                   optionalDate(true) && optionalTime("start", cmd.start, cmd.hasStart, true) &&
+                   optionalTime("end", cmd.end, cmd.hasEnd, true);
+        case BatchOp::UpdateBooking:
+            if (json.has("client") && !requireName("client")) {
+                return false;
+            }
+            return requireInt("id", cmd.id) && optionalInt("workstation", cmd.workstationId, cmd.hasWorkstation) &&
+                   optionalDate(false) && optionalTime("start", cmd.start, cmd.hasStart, false) &&
+                   optionalTime("end", cmd.end, cmd.hasEnd, false);
+        case BatchOp::PurgeExpired:
+            return true;
+        case BatchOp::BookingsForDay:
+            return optionalDate(true);
+        case BatchOp::IsFree:
+            return optionalInt("workstation", cmd.workstationId, cmd.hasWorkstation) && optionalDate(true) &&
+                   optionalTime("start", cmd.start, cmd.hasStart, true) && optionalTime("end", cmd.end, cmd.hasEnd, true);
+    }
+    return true;
+}
+
+// Ограниченная очередь порций команд между потоком чтения и выполнением.
+class ParsedChunks {
+private:
+    mutex chunksMutex;
+    condition_variable notFull;
+    condition_variable notEmpty;
+    deque<vector<BatchCommand>> chunks;
+    size_t limit;
+    bool finished = false;
+    bool cancelled = false;
+
+public:
+    explicit ParsedChunks(size_t _limit) : limit(_limit ? _limit : 1) {}
+
+    // false — выполнение прервано, читать дальше не нужно.
+    bool push(vector<BatchCommand>&& chunk) {
+        unique_lock<mutex> lock(chunksMutex);
+        notFull.wait(lock, [this] { return cancelled || chunks.size() < limit; });
+        if (cancelled) {
+            return false;
+        }
+        chunks.push_back(move(chunk));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // false — ввод кончился и все порции забраны.
+    bool pop(vector<BatchCommand>& chunk) {
+        unique_lock<mutex> lock(chunksMutex);
+        notEmpty.wait(lock, [this] { return finished || !chunks.empty(); });
+        if (chunks.empty()) {
+            return false;
+        }
+        chunk = move(chunks.front());
+        chunks.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void finish() {
+        lock_guard<mutex> lock(chunksMutex);
+        finished = true;
+        notEmpty.notify_one();
+    }
+
+    void cancel() {
+        lock_guard<mutex> lock(chunksMutex);
+        cancelled = true;
+        notFull.notify_one();
+    }
+};
+
+static void readCommands(istream& in, ParsedChunks& parsed, size_t chunkLines) {
+    JsonLine json;
+    string text;
+    size_t lineNumber = 0;
+    vector<BatchCommand> chunk;
+    chunk.reserve(chunkLines);
+    while (getline(in, text)) {
+        ++lineNumber;
+        if (text.find_first_not_of(" \t\r") == string::npos) {
+            continue;
+        }
+        BatchCommand& cmd = chunk.emplace_back();
+        cmd.line = lineNumber;
+        if (json.parse(text, cmd.error)) {
+            parseCommand(json, cmd);
+        }
+        if (chunk.size() >= chunkLines) {
+            if (!parsed.push(move(chunk))) {
+                return;
+            }
+            chunk.clear();
+            chunk.reserve(chunkLines);
+        }
+    }
+    if (!chunk.empty()) {
+        parsed.push(move(chunk));
+    }
+}
+
+static void appendTime(string& out, TimeOfDay time) {
+    out += static_cast<char>('0' + time.hour() / 10);
+    out += static_cast<char>('0' + time.hour() % 10);
+    out += ':';
+    out += static_cast<char>('0' + time.minute() / 10);
+    out += static_cast<char>('0' + time.minute() % 10);
+}
+
+static void appendIds(string& out, const char* key, const vector<int>& ids) {
+    out += ",\"";
+    out += key;
+    out += "\":[";
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i) {
+            out += ',';
+        }
+        out += to_string(ids[i]);
+    }
+    out += ']';
+}
+
+static void appendStatus(string& out, const char* status) {
+    out += ",\"status\":\"";
+    out += status;
+    out += '"';
+}
+
+static void appendEngineResult(string& out, const EngineResult& result, BatchSummary& summary) {
+    appendStatus(out, engineErrorName(result.error));
+    if (result.ok()) {
+        ++summary.succeeded;
+    } else {
+        ++summary.rejected;
+    }
+    if (result.error == EngineError::Conflict) {
+        appendIds(out, "conflicts", result.conflictingIds);
+    }
+    if (result.workstationBooked) {
+        out += ",\"workstation_booked\":true";
+    }
+    if (result.workstationReleased) {
+        out += ",\"workstation_released\":true";
+    }
+}
+
+static void appendBooking(string& out, const Booking& b, const string& clientName) {
+    out += ",\"workstation\":" + to_string(b.getWorkstationId()) + ",\"client\":";
+    appendJsonString(out, clientName);
+    out += ",\"date\":\"" + b.getBookingDate().toString() + "\",\"start\":\"";
+    appendTime(out, b.getStartTime());
+    out += "\",\"end\":\"";
+    appendTime(out, b.getEndTime());
+    out += '"';
+}
+
+static bool hasWorkstation(const BookingEngine& engine, int id) {
+    return engine.findWorkstation(id) != nullptr;
+}
+
+static bool hasWorkstation(const ShardedEngine& engine, int id) {
+    return engine.hasWorkstation(id);
+}
+
+static vector<int> workstationIds(const BookingEngine& engine) {
+    vector<int> ids;
+    ids.reserve(engine.getWorkstations().size());
+    for (const auto& ws : engine.getWorkstations()) {
+        ids.push_back(workstationId(ws));
+    }
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+static vector<int> workstationIds(const ShardedEngine& engine) {
+    return engine.workstationIds();
+}
+
+// Команды-запросы: у BookingEngine и ShardedEngine одинаковые методы.
+template <typename Engine>
+static void runQuery(const Engine& engine, const BatchCommand& cmd, string& out, BatchSummary& summary) {
+    switch (cmd.op) {
+        case BatchOp::ListWorkstations:
+            appendEngineResult(out, EngineResult(), summary);
+            appendIds(out, "ids", cmd.hasStatus ? engine.workstationsWithStatus(cmd.status) : workstationIds(engine));
+            return;
+        case BatchOp::BookingsForDay:
+            appendEngineResult(out, EngineResult(), summary);
+            appendIds(out, "ids", engine.bookingsForDay(cmd.date));
+            return;
+        case BatchOp::IsFree: {
+            EngineResult result;
+            if (cmd.hasWorkstation && !hasWorkstation(engine, cmd.workstationId)) {
+                result.error = EngineError::WorkstationNotFound;
+            } else if (cmd.start >= cmd.end) {
+                result.error = EngineError::InvalidInterval;
+            }
+            appendEngineResult(out, result, summary);
+            if (!result.ok()) {
+                return;
+            }
+            if (cmd.hasWorkstation) {
+                out += engine.isFree(cmd.workstationId, cmd.date, cmd.start, cmd.end) ? ",\"free\":true" : ",\"free\":false";
+            } else {
+                // Без станции — все свободные станции одним проходом.
+                appendIds(out, "free", engine.freeWorkstations(cmd.date, cmd.start, cmd.end));
+            }
+            return;
+        }
+        default:
+            throw logic_error("runQuery: команда не запрос");
+    }
+}
+
+static void runCommand(BookingEngine& engine, const BatchCommand& cmd, string& out, BatchSummary& summary) {
+    switch (cmd.op) {
+        case BatchOp::AddWorkstation:
+            appendEngineResult(out, engine.addWorkstation(cmd.rating > 0
+                ? AnyWorkstation(SpecialWorkstation(cmd.id, cmd.name, WorkstationStatus::Available, cmd.rating))
+                : AnyWorkstation(Workstation(cmd.id, cmd.name))), summary);
+            return;
+        case BatchOp::DeleteWorkstation:
+            appendEngineResult(out, engine.deleteWorkstation(cmd.id), summary);
+            return;
+        case BatchOp::SetStatus:
+            appendEngineResult(out, engine.setWorkstationStatus(cmd.id, cmd.status), summary);
+            return;
+        case BatchOp::AddBooking:
+            appendEngineResult(out, engine.addBooking(
+                BookingRequest{ cmd.id, cmd.workstationId, cmd.name, cmd.date, cmd.start, cmd.end }), summary);
+            return;
+        case BatchOp::UpdateBooking: {
+            optional<Booking> existing = engine.findBooking(cmd.id);
+            if (!existing) {
+                EngineResult result;
+                result.error = EngineError::BookingNotFound;
+                appendEngineResult(out, result, summary);
+                return;
+            }
+            appendEngineResult(out, engine.updateBooking(BookingRequest{
+                cmd.id,
+                cmd.hasWorkstation ? cmd.workstationId : existing->getWorkstationId(),
+                cmd.name,
+                cmd.hasDate ? cmd.date : existing->getBookingDate(),
+                cmd.hasStart ? cmd.start : existing->getStartTime(),
+                cmd.hasEnd ? cmd.end : existing->getEndTime() }), summary);
+            return;
+        }
+        case BatchOp::CancelBooking:
+            appendEngineResult(out, engine.cancelBooking(cmd.id), summary);
+            return;
+        case BatchOp::PurgeExpired: {
+            PurgeResult purged = engine.purgeExpired();
+            appendEngineResult(out, EngineResult(), summary);
+            appendIds(out, "expired", purged.bookingIds);
+            appendIds(out, "released", purged.releasedWorkstationIds);
+            return;
+        }
+        case BatchOp::GetBooking: {
+            optional<Booking> b = engine.findBooking(cmd.id);
+            EngineResult result;
+            if (!b) {
+                result.error = EngineError::BookingNotFound;
+            }
+            appendEngineResult(out, result, summary);
+            if (b) {
+                appendBooking(out, *b, engine.getClients().nameOf(b->getClientId()));
+            }
+            return;
+        }
+        case BatchOp::ListWorkstations:
+        case BatchOp::BookingsForDay:
+        case BatchOp::IsFree:
+            runQuery(engine, cmd, out, summary);
+            return;
+    }
+}
+
+// Строка ответа: номер строки, команда и то, что допишет run; исключение
+// из run превращается в ответ error.
+template <typename Run>
+static void appendReply(const BatchCommand& cmd, string& out, BatchSummary& summary, Run run) {
+    ++summary.commands;
+    out += "{\"line\":" + to_string(cmd.line);
+    if (cmd.opName) {
+        out += ",\"op\":\"";
+        out += cmd.opName;
+        out += '"';
+    }
+    if (!cmd.error.empty()) {
+        ++summary.invalid;
+        appendStatus(out, "invalid");
+        out += ",\"message\":";
+        appendJsonString(out, cmd.error);
+    } else {
+        size_t mark = out.size();
+        try {
+            run();
+        } catch (const exception& e) {
+            // Точка сохранения операции уже откатана, пачка продолжается.
+            out.resize(mark);
+            ++summary.failed;
+            appendStatus(out, "error");
+            out += ",\"message\":";
+            appendJsonString(out, e.what());
+        }
+    }
+    out += "}\n";
+}
+
+static void executeCommand(BookingEngine& engine, const BatchCommand& cmd, string& out, BatchSummary& summary) {
+    appendReply(cmd, out, summary, [&] { runCommand(engine, cmd, out, summary); });
+}
+
+void executeCommandLine(BookingEngine& engine, string_view line, size_t lineNumber, string& out, BatchSummary& summary) {
+    JsonLine json;
+    BatchCommand cmd;
+    cmd.line = lineNumber;
+    if (json.parse(line, cmd.error)) {
+        parseCommand(json, cmd);
+    }
+    executeCommand(engine, cmd, out, summary);
+}
+
+// Начало команды на ShardedEngine: изменение уходит в очередь раздела
+// (future готов после COMMIT пачки раздела), остальное делает продолжение.
+static PendingReply startCommand(ShardedEngine& engine, const BatchCommand& cmd) {
+    auto awaitResult = [](future<EngineResult> result) -> PendingReply {
+        shared_future<EngineResult> shared = result.share();
+        return [shared](string& out, BatchSummary& summary) { appendEngineResult(out, shared.get(), summary); };
+    };
+    switch (cmd.op) {
+        case BatchOp::AddWorkstation:
+            return awaitResult(engine.addWorkstation(cmd.rating > 0
+                ? AnyWorkstation(SpecialWorkstation(cmd.id, cmd.name, WorkstationStatus::Available, cmd.rating))
+                : AnyWorkstation(Workstation(cmd.id, cmd.name))));
+        case BatchOp::DeleteWorkstation:
+            return awaitResult(engine.deleteWorkstation(cmd.id));
+        case BatchOp::SetStatus:
+            return awaitResult(engine.setWorkstationStatus(cmd.id, cmd.status));
+        case BatchOp::AddBooking:
+            return awaitResult(engine.addBooking(BookingRequest{ cmd.id, cmd.workstationId, cmd.name, cmd.date, cmd.start, cmd.end }));
+        case BatchOp::UpdateBooking: {
+            optional<Booking> existing = engine.findBooking(cmd.id).get();
+            if (!existing) {
+                return [](string& out, BatchSummary& summary) {
+                    EngineResult result;
+                    result.error = EngineError::BookingNotFound;
+                    appendEngineResult(out, result, summary);
+                };
+            }
+            return awaitResult(engine.updateBooking(BookingRequest{
+                cmd.id,
+                cmd.hasWorkstation ? cmd.workstationId : existing->getWorkstationId(),
+                cmd.name,
+                cmd.hasDate ? cmd.date : existing->getBookingDate(),
+                cmd.hasStart ? cmd.start : existing->getStartTime(),
+                cmd.hasEnd ? cmd.end : existing->getEndTime() }));
+        }
+        case BatchOp::CancelBooking:
+            return awaitResult(engine.cancelBooking(cmd.id));
+        case BatchOp::PurgeExpired:
+            return [&engine](string& out, BatchSummary& summary) {
+                PurgeResult purged = engine.purgeExpired();
+                appendEngineResult(out, EngineResult(), summary);
+                appendIds(out, "expired", purged.bookingIds);
+                appendIds(out, "released", purged.releasedWorkstationIds);
+            };
+        case BatchOp::GetBooking: {
+            shared_future<optional<Booking>> found = engine.findBooking(cmd.id).share();
+            return [&engine, found](string& out, BatchSummary& summary) {
+                const optional<Booking>& b = found.get();
+                EngineResult result;
+                if (!b) {
+                    result.error = EngineError::BookingNotFound;
+                    appendEngineResult(out, result, summary);
+                    return;
+                }
+                // Справочник клиентов — у движка раздела станции.
+                int clientId = b->getClientId();
+                string clientName = engine.submit(engine.shardFor(b->getWorkstationId()), [clientId](BookingEngine& shard) {
+                    return shard.getClients().nameOf(clientId);
+                }).get();
+                appendEngineResult(out, result, summary);
+                appendBooking(out, *b, clientName);
+            };
+        }
+        case BatchOp::ListWorkstations:
+        case BatchOp::BookingsForDay:
+        case BatchOp::IsFree:
+            return [&engine, cmd](string& out, BatchSummary& summary) { runQuery(engine, cmd, out, summary); };
+    }
+    throw logic_error("startCommand: неизвестная команда");
+}
+
+PendingReply startCommandLine(ShardedEngine& engine, string_view line, size_t lineNumber) {
+    JsonLine json;
+    BatchCommand cmd;
+    cmd.line = lineNumber;
+    if (json.parse(line, cmd.error)) {
+        parseCommand(json, cmd);
+    }
+    PendingReply started;
+    exception_ptr error;
+    if (cmd.error.empty()) {
+        try {
+            started = startCommand(engine, cmd);
+        } catch (...) {
+            error = current_exception();
+        }
+    }
+    return [cmd = move(cmd), started = move(started), error](string& out, BatchSummary& summary) {
+        appendReply(cmd, out, summary, [&] {
+            if (error) {
+                rethrow_exception(error);
+            }
+            started(out, summary);
+        });
+    };
+}
+
+BatchSummary runBatch(BookingEngine& engine, istream& in, ostream& out, const BatchOptions& options) {
+    BatchSummary summary;
+    auto begin = chrono::steady_clock::now();
+    size_t commitEvery = options.commitEvery ? options.commitEvery : 1;
+    size_t chunkLines = options.chunkLines ? options.chunkLines : 1;
+
+    ParsedChunks parsed(options.chunksAhead);
+    thread reader([&] {
+        readCommands(in, parsed, chunkLines);
+        parsed.finish();
+    });
+
+    unique_ptr<UnitOfWork> work;
+    size_t inGroup = 0;
+    size_t groupFirstLine = 0;
+    size_t groupLastLine = 0;
+    string results;
+    auto commitGroup = [&] {
+        try {
+            // С writeBehind пишет очередь движка: её COMMIT и есть фиксация пачки.
+            if (work) {
+                work->commit();
+            } else {
+                engine.flushWrites();
+            }
+        } catch (const exception& e) {
+            throw runtime_error("Не удалось зафиксировать команды строк " + to_string(groupFirstLine) + "-" +
+                                to_string(groupLastLine) + ": " + e.what());
+        }
+        work.reset();
+        ++summary.commits;
+        inGroup = 0;
+        out << results;
+        results.clear();
+    };
+
+    try {
+        vector<BatchCommand> chunk;
+        while (parsed.pop(chunk)) {
+            for (const BatchCommand& cmd : chunk) {
+                if (inGroup == 0) {
+                    if (!engine.writesBehind()) {
+                        work = make_unique<UnitOfWork>(engine.getManager());
+                    }
+                    groupFirstLine = cmd.line;
+                }
+                groupLastLine = cmd.line;
+                executeCommand(engine, cmd, results, summary);
+                if (++inGroup >= commitEvery) {
+                    commitGroup();
+                }
+            }
+        }
+        if (inGroup > 0) {
+            commitGroup();
+        }
+    } catch (...) {
+        parsed.cancel();
+        reader.join();
+        throw;
+    }
+    reader.join();
+    out.flush();
+
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    return summary;
+}
@@ -0,0 +1,70 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+class BookingEngine;
+class ShardedEngine;
+
+struct BatchOptions {
+    // Команд в одной транзакции: результаты пачки выводятся после её COMMIT.
+    std::size_t commitEvery = 512;
+    // Строк в одной порции разбора и порций, разобранных наперёд.
+    std::size_t chunkLines = 256;
+    std::size_t chunksAhead = 8;
+};
+
+struct BatchSummary {
+    std::size_t commands = 0;
+    std::size_t succeeded = 0;
+    std::size_t rejected = 0;  // отклонены движком: конфликт, нет станции и т.п.
+    std::size_t invalid = 0;   // строка не разобрана или команда неизвестна
+    std::size_t failed = 0;    // ошибка базы данных
+    std::size_t commits = 0;
+    double seconds = 0;
+
+    double commandsPerSecond() const { return seconds > 0 ? static_cast<double>(commands) / seconds : 0; }
+};
+
+// Пакетный режим: команды JSONL из in выполняются движком, на каждую
+// непустую строку в out пишется строка JSONL с результатом. Разбор идёт в
+// отдельном потоке на несколько порций впереди выполнения; изменения
+// фиксируются пачками по commitEvery команд. Если COMMIT пачки не удался,
+// бросается runtime_error: данные движка в памяти уже не совпадают с базой.
+//
+// Команды (поле "op"):
+//   add_workstation    id, name, [rating > 0 — премиум-станция]
+//   delete_workstation id
+//   set_status         id, status (available | booked | maintenance)
+//   add_booking        id, workstation, client, date (DD-MM-YYYY), start, end (HH:MM)
+//   update_booking     id, [workstation, client, date, start, end] — по умолчанию прежние
+//   cancel_booking     id
+//   purge_expired
+//   get_booking        id
+//   list_workstations  [status]
+//   bookings_for_day   date
+//   is_free            [workstation], date, start, end — без станции: ID всех свободных
+BatchSummary runBatch(BookingEngine& engine, std::istream& in, std::ostream& out,
+                      const BatchOptions& options = BatchOptions());
+
+// Разбирает и выполняет одну непустую строку-команду в текущей транзакции
+// и дописывает в out строку результата с переводом строки; lineNumber
+// попадает в поле "line" ответа. Общий разбор команд для runBatch и сервера.
+void executeCommandLine(BookingEngine& engine, std::string_view line, std::size_t lineNumber, std::string& out,
+                        BatchSummary& summary);
+
+// Ответ на команду, уже отправленную в разделы ShardedEngine: дожидается
+// результата и дописывает в out строку ответа.
+using PendingReply = std::function<void(std::string& out, BatchSummary& summary)>;
+
+// Разбирает строку-команду и отправляет изменение в очередь раздела, не
+// дожидаясь его COMMIT; запросы выполняются при вызове ответа. Команды
+// одного клиента начинаются по одной — следующая после ответа на
+// предыдущую: только так она видит результат предыдущей.
+PendingReply startCommandLine(ShardedEngine& engine, std::string_view line, std::size_t lineNumber);
+
+#endif // BATCH_RUNNER_H
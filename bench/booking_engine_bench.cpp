@@ -0,0 +1,98 @@
+// Пропускная способность BookingEngine без консоли: добавление, выборки и
+// отмена броней на временной базе.
+// Сборка: cmake -DKPK_BUILD_BENCHMARKS=ON, цель kpk_engine_bench.
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "../booking_engine.h"
+#include "../civil_date.h"
+
+using namespace std;
+
+template <typename F>
+static double measureUs(size_t operations, F&& body) {
+    auto begin = chrono::steady_clock::now();
+    body();
+    auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin);
+    return static_cast<double>(elapsed.count()) / 1000.0 / static_cast<double>(operations);
+}
+
+int main() {
+    const int stations = 200;
+    const int count = 20000;
+    const char* path = "kpk_engine_bench.db";
+    remove(path);
+
+    EngineConfig config;
+    config.storage.path = path;
+    config.storage.synchronous = SynchronousLevel::Off;
+    config.backgroundExpiry = false;
+
+    size_t failed = 0;
+    long long checksum = 0;
+    {
+        BookingEngine engine(config);
+        for (int id = 1; id <= stations; ++id) {
+            engine.addWorkstation(Workstation(id, "Станция " + to_string(id)));
+        }
+
+        // Каждой станции — по часу в день, начиная с завтрашнего.
+        Date tomorrow(toLocalDateTime(chrono::system_clock::now()).date.days() + 1);
+        auto requestFor = [&](int i) {
+            int slot = i / stations;
+            Date day(tomorrow.days() + slot / 8);
+            TimeOfDay start(9 + slot % 8, 0);
+            TimeOfDay end(10 + slot % 8, 0);
+            return BookingRequest{ i + 1, i % stations + 1, "Клиент " + to_string(i % 500), day, start, end };
+        };
+
+        double addUs = measureUs(count, [&] {
+            for (int i = 0; i < count; ++i) {
+                failed += !engine.addBooking(requestFor(i)).ok();
+            }
+        });
+        double conflictUs = measureUs(count, [&] {
+            for (int i = 0; i < count; ++i) {
+                BookingRequest request = requestFor(i);
+                request.bookingId += count;
+                failed += engine.addBooking(request).error != EngineError::Conflict;
+            }
+        });
+        double dayUs = measureUs(100, [&] {
+            for (int i = 0; i < 100; ++i) {
+                checksum += static_cast<long long>(engine.bookingsForDay(Date(tomorrow.days() + i % 10)).size());
+            }
+        });
+        double freeUs = measureUs(count, [&] {
+            for (int i = 0; i < count; ++i) {
+                BookingRequest request = requestFor(i);
+                checksum += engine.isFree(request.workstationId, request.bookingDate, request.startTime, request.endTime);
+            }
+        });
+        double snapshotFreeUs = measureUs(count, [&] {
+            for (int i = 0; i < count; ++i) {
+                BookingRequest request = requestFor(i);
+                checksum += engine.readSchedule()->isFree(request.workstationId, request.bookingDate, request.startTime, request.endTime);
+            }
+        });
+        double cancelUs = measureUs(count, [&] {
+            for (int i = 0; i < count; ++i) {
+                failed += !engine.cancelBooking(i + 1).ok();
+            }
+        });
+
+        cout << fixed << setprecision(2)
+             << "addBooking: " << addUs << " мкс/операция\n"
+             << "addBooking с конфликтом: " << conflictUs << " мкс/операция\n"
+             << "bookingsForDay: " << dayUs << " мкс/запрос\n"
+             << "isFree: " << freeUs << " мкс/запрос\n"
+             << "isFree по версии расписания: " << snapshotFreeUs << " мкс/запрос\n"
+             << "cancelBooking: " << cancelUs << " мкс/операция\n"
+             << "ошибок: " << failed << ", контрольная сумма: " << checksum << endl;
+    }
+    remove(path);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+// Сравнение date_time_parser с прежним разбором через std::regex и std::get_time.
+// Сборка: cmake -DKPK_BUILD_BENCHMARKS=ON, цель kpk_parser_bench.
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../date_time_parser.h"
+
+using namespace std;
+
+// Прежние версии из main.cpp и booking.cpp — база для сравнения.
+struct LegacyTime {
+    int hour;
+    int minute;
+};
+
+static bool legacyParseTime(const string& timeStr, LegacyTime& resultTime) {
+    regex time_regex("^([01]?[0-9]|2[0-3]):([0-5][0-9])$");
+    smatch match;
+    if (regex_match(timeStr, match, time_regex) && match.size() == 3) {
+        resultTime.hour = stoi(match[1].str());
+        resultTime.minute = stoi(match[2].str());
+        return true;
+    }
+    return false;
+}
+
+static bool legacyIsValidDate(const string& dateStr) {
+    regex date_regex("^([0-2][0-9]|3[01])-(0[1-9]|1[0-2])-([0-9]{4})$");
+    return regex_match(dateStr, date_regex);
+}
+
+static bool legacyParseDateTime(const string& dateStr, const LegacyTime& t, tm& result) {
+    stringstream ss;
+    ss << dateStr << " " << setw(2) << setfill('0') << t.hour << ":" << setw(2) << setfill('0') << t.minute << ":00";
+    ss >> get_time(&result, "%d-%m-%Y %H:%M:%S");
+    return !ss.fail();
+}
+
+template <typename F>
+static double measureNs(size_t operations, F&& body) {
+    auto begin = chrono::steady_clock::now();
+    body();
+    auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin);
+    return static_cast<double>(elapsed.count()) / static_cast<double>(operations);
+}
+
+int main() {
+    const size_t count = 200000;
+    vector<string> dates;
+    vector<string> times;
+    dates.reserve(count);
+    times.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%02d-%02d-%04d", static_cast<int>(i % 28 + 1), static_cast<int>(i % 12 + 1),
+                 static_cast<int>(2000 + i % 50));
+        dates.emplace_back(buffer);
+        snprintf(buffer, sizeof(buffer), "%02d:%02d", static_cast<int>(i % 24), static_cast<int>(i % 60));
+        times.emplace_back(buffer);
+    }
+
+    long long checksum = 0;
+    double legacyNs = measureNs(count, [&] {
+        for (size_t i = 0; i < count; ++i) {
+            LegacyTime t{};
+            tm parsed = {};
+            if (legacyIsValidDate(dates[i]) && legacyParseTime(times[i], t) && legacyParseDateTime(dates[i], t, parsed)) {
+                checksum += parsed.tm_mday + t.minute;
+            }
+        }
+    });
+
+    double parserNs = measureNs(count, [&] {
+        for (size_t i = 0; i < count; ++i) {
+            Date day;
+            TimeOfDay t;
+            if (parseDate(dates[i], day) && parseTime(times[i], t)) {
+                checksum += day.toCivil().day + t.minute();
+            }
+        }
+    });
+
+    vector<string_view> views(dates.begin(), dates.end());
+    vector<Date> days;
+    size_t failed = 0;
+    double batchNs = measureNs(count, [&] { failed = parseDates(views, days); });
+
+    cout << fixed << setprecision(1)
+         << "regex + get_time: " << legacyNs << " нс/запись\n"
+         << "parseDate + parseTime: " << parserNs << " нс/запись (x" << legacyNs / parserNs << ")\n"
+         << "parseDates (пакет): " << batchNs << " нс/дата, ошибок: " << failed << "\n"
+         << "контрольная сумма: " << checksum << endl;
+    return 0;
+}
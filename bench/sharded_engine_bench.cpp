@@ -0,0 +1,108 @@
+// Пропускная способность ShardedEngine: добавление броней из нескольких
+// потоков при разном числе разделов, с общей базой и с базой на раздел.
+// Рост — во сколько раз быстрее, чем с одним разделом; выше числа ядер
+// (hardware_concurrency) он не поднимется.
+// Сборка: cmake -DKPK_BUILD_BENCHMARKS=ON, цель kpk_sharded_bench.
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../sharded_engine.h"
+#include "../civil_date.h"
+
+using namespace std;
+
+static void removeDatabase(const string& path) {
+    for (const char* suffix : { "", "-wal", "-shm" }) {
+        remove((path + suffix).c_str());
+    }
+}
+
+// Операций addBooking в секунду; failed — сколько операций не удалось.
+static double measure(unsigned shardCount, bool storagePerShard, size_t& failed) {
+    const int stations = 256;
+    const int count = 40000;
+    const unsigned producers = 8;
+    const string path = "kpk_sharded_bench.db";
+
+    auto removeAll = [&] {
+        removeDatabase(path);
+        for (unsigned shard = 0; shard < shardCount; ++shard) {
+            removeDatabase(path + "." + to_string(shard));
+        }
+    };
+    removeAll();
+    double seconds;
+    {
+        ShardedEngineConfig config;
+        config.engine.storage.path = path;
+        config.engine.storage.synchronous = SynchronousLevel::Off;
+        config.engine.backgroundExpiry = false;
+        config.shards = shardCount;
+        config.storagePerShard = storagePerShard;
+        ShardedEngine engine(config);
+
+        vector<future<EngineResult>> added;
+        for (int id = 1; id <= stations; ++id) {
+            added.push_back(engine.addWorkstation(Workstation(id, "Станция " + to_string(id))));
+        }
+        for (auto& result : added) {
+            failed += !result.get().ok();
+        }
+
+        // Каждой станции — по часу в день, начиная с завтрашнего.
+        Date tomorrow(toLocalDateTime(chrono::system_clock::now()).date.days() + 1);
+        auto begin = chrono::steady_clock::now();
+        vector<thread> threads;
+        vector<size_t> threadFailed(producers);
+        for (unsigned p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                vector<future<EngineResult>> results;
+                for (int i = static_cast<int>(p); i < count; i += static_cast<int>(producers)) {
+                    int slot = i / stations;
+                    Date day(tomorrow.days() + slot / 8);
+                    results.push_back(engine.addBooking(BookingRequest{ i + 1, i % stations + 1, "Клиент " + to_string(i % 500),
+                                                                        day, TimeOfDay(9 + slot % 8, 0), TimeOfDay(10 + slot % 8, 0) }));
+                }
+                for (auto& result : results) {
+                    threadFailed[p] += !result.get().ok();
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        for (size_t f : threadFailed) {
+            failed += f;
+        }
+    }
+    removeAll();
+    return static_cast<double>(count) / seconds;
+}
+
+int main() {
+    size_t failed = 0;
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    unsigned maxShards = max(8u, cores);
+    cout << "ядер: " << cores << endl;
+    for (bool storagePerShard : { false, true }) {
+        cout << (storagePerShard ? "база на раздел" : "общая база") << endl;
+        double single = 0;
+        for (unsigned shardCount = 1; shardCount <= maxShards; shardCount *= 2) {
+            double rate = measure(shardCount, storagePerShard, failed);
+            if (shardCount == 1) {
+                single = rate;
+            }
+            cout << fixed << setprecision(0) << "  разделов: " << shardCount << ", addBooking: " << rate
+                 << " операций/с" << setprecision(2) << ", рост: x" << rate / single << endl;
+        }
+    }
+    cout << "ошибок: " << failed << endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -3,34 +3,41 @@
 
 #include <string>
 #include <iostream>
-#include <chrono>
-#include "time.h"
+#include "Time.h"
+#include "civil_date.h"
+
+class ClientDirectory;
 
 class Booking {
 private:
     int bookingId;
     int workstationId;
-    std::string clientName;
-    std::string bookingDate; // DD-MM-YYYY
-    Time startTime;
-    Time endTime;
+    int clientId; // Clients.id, имя — в ClientDirectory
+    Date bookingDate;
+    TimeOfDay startTime;
+    TimeOfDay endTime;
 
 public:
-    Booking(int _bookingId, int _workstationId, const std::string& _clientName, const std::string& _bookingDate, Time _start, Time _end);
+    Booking(int _bookingId, int _workstationId, int _clientId, Date _bookingDate, TimeOfDay _start, TimeOfDay _end);
 
-    void display() const;
+    void display(const ClientDirectory& clients) const;
 
-    void updateTime(Time newStart, Time newEnd);
+    void updateTime(TimeOfDay newStart, TimeOfDay newEnd);
     void updateTime(int startHour, int startMinute, int endHour, int endMinute);
 
     int getBookingId() const { return bookingId; }
     int getWorkstationId() const { return workstationId; }
-    std::string getClientName() const { return clientName; }
-    std::string getBookingDate() const { return bookingDate; }
-    Time getStartTime() const { return startTime; }
-    Time getEndTime() const { return endTime; }
-
-    std::chrono::system_clock::time_point getEndDateTime() const;
+    int getClientId() const { return clientId; }
+    Date getBookingDate() const { return bookingDate; }
+    TimeOfDay getStartTime() const { return startTime; }
+    TimeOfDay getEndTime() const { return endTime; }
+
+    // Начало и конец в минутах местного времени от 01-01-1970 (см. civil_date.h).
+    long long getStartInstant() const { return toLocalInstant(bookingDate, startTime); }
+    long long getEndInstant() const { return toLocalInstant(bookingDate, endTime); }
+    bool hasValidDate() const { return bookingDate.isValid(); }
+    // nowInstant — результат localInstantNow(); достаточно получить его один раз на весь проход.
+    bool isExpiredAt(long long nowInstant) const { return hasValidDate() && getEndInstant() <= nowInstant; }
 
     bool operator==(const Booking& other) const;
 };
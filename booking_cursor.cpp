@@ -0,0 +1,54 @@
+#include "booking_cursor.h"
+#include <sqlite3.h>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static string_view columnView(sqlite3_stmt* stmt, int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    if (!text) {
+        return string_view();
+    }
+    return string_view(reinterpret_cast<const char*>(text), static_cast<size_t>(sqlite3_column_bytes(stmt, column)));
+}
+
+BookingCursor::BookingCursor(CachedStatement&& _stmt) : stmt(move(_stmt)), current{ 0, 0, 0, Date(), TimeOfDay(), TimeOfDay() } {}
+
+bool BookingCursor::next() {
+    int rc = sqlite3_step(stmt.get());
+    if (rc == SQLITE_DONE) {
+        return false;
+    }
+    if (rc != SQLITE_ROW) {
+        throw runtime_error("Ошибка чтения бронирований: " + string(sqlite3_errmsg(sqlite3_db_handle(stmt.get()))));
+    }
+    current.bookingId = sqlite3_column_int(stmt.get(), 0);
+    current.workstationId = sqlite3_column_int(stmt.get(), 1);
+    current.clientId = sqlite3_column_int(stmt.get(), 2);
+    current.bookingDate = Date(sqlite3_column_int(stmt.get(), 3));
+    current.startTime = TimeOfDay(sqlite3_column_int(stmt.get(), 4));
+    current.endTime = TimeOfDay(sqlite3_column_int(stmt.get(), 5));
+    return true;
+}
+
+WorkstationCursor::WorkstationCursor(CachedStatement&& _stmt) : stmt(move(_stmt)), current{ 0, {}, WorkstationStatus::Available, WorkstationKind::Standard, 0 } {}
+
+bool WorkstationCursor::next() {
+    int rc = sqlite3_step(stmt.get());
+    if (rc == SQLITE_DONE) {
+        return false;
+    }
+    if (rc != SQLITE_ROW) {
+        throw runtime_error("Ошибка чтения рабочих станций: " + string(sqlite3_errmsg(sqlite3_db_handle(stmt.get()))));
+    }
+    current.id = sqlite3_column_int(stmt.get(), 0);
+    current.name = columnView(stmt.get(), 1);
+    if (!statusFromInt(sqlite3_column_int(stmt.get(), 2), current.status)) {
+        throw runtime_error("Неизвестный статус станции " + to_string(current.id) + " в базе данных");
+    }
+    current.kind = sqlite3_column_int(stmt.get(), 3) == static_cast<int>(WorkstationKind::Premium)
+                       ? WorkstationKind::Premium : WorkstationKind::Standard;
+    current.rating = sqlite3_column_int(stmt.get(), 4);
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef BOOKING_CURSOR_H
+#define BOOKING_CURSOR_H
+
+#include <string_view>
+#include "statement_cache.h"
+#include "Time.h"
+#include "civil_date.h"
+#include "workstation.h"
+
+// Строки курсоров ссылаются на буферы SQLite: string_view-поля
+// действительны только до следующего вызова next() или закрытия курсора.
+struct BookingRow {
+    int bookingId;
+    int workstationId;
+    int clientId;
+    Date bookingDate;
+    TimeOfDay startTime;
+    TimeOfDay endTime;
+};
+
+struct WorkstationRow {
+    int id;
+    std::string_view name;
+    WorkstationStatus status;
+    WorkstationKind kind;
+    int rating;
+};
+
+class BookingCursor {
+private:
+    CachedStatement stmt;
+    BookingRow current;
+
+public:
+    explicit BookingCursor(CachedStatement&& _stmt);
+    BookingCursor(BookingCursor&&) = default;
+
+    bool next();
+    const BookingRow& row() const { return current; }
+};
+
+class WorkstationCursor {
+private:
+    CachedStatement stmt;
+    WorkstationRow current;
+
+public:
+    explicit WorkstationCursor(CachedStatement&& _stmt);
+    WorkstationCursor(WorkstationCursor&&) = default;
+
+    bool next();
+    const WorkstationRow& row() const { return current; }
+};
+
+#endif // BOOKING_CURSOR_H
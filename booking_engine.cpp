@@ -0,0 +1,431 @@
+#include "booking_engine.h"
+#include "expiry_scheduler.h"
+#include "civil_date.h"
+#include <algorithm>
+
+using namespace std;
+
+BookingEngine::BookingEngine(const EngineConfig& config)
+    : manager(make_unique<BookingManager>(config.storage)),
+      shardCount(config.shardCount ? config.shardCount : 1),
+      shardIndex(config.shardIndex),
+      schedule(config.schedule ? config.schedule : make_shared<SchedulePublisher>()) {
+    load();
+    if (config.writeBehind) {
+        writes = make_unique<WriteBehindQueue>(config.storage, config.writeBehindConfig);
+    }
+    if (config.backgroundExpiry) {
+        expiry = make_unique<ExpiryScheduler>(config.storage);
+        scheduleExpiry();
+    }
+}
+
+BookingEngine::~BookingEngine() = default;
+
+// Брони, закончившиеся до загрузки, удаляет purgeExpired().
+void BookingEngine::scheduleExpiry() {
+    long long nowInstant = localInstantNow();
+    for (size_t row = 0; row < bookings.size(); ++row) {
+        Booking b = bookings.rowAt(row);
+        if (!b.isExpiredAt(nowInstant)) {
+            expiry->schedule(b);
+        }
+    }
+}
+
+void BookingEngine::reload() {
+    if (writes) {
+        writes->flush();
+        collectWrites(true);
+        writeError = nullptr;
+    }
+    if (expiry) {
+        for (size_t row = 0; row < bookings.size(); ++row) {
+            expiry->cancel(bookings.rowAt(row).getBookingId());
+        }
+    }
+    workstations.clear();
+    bookings.clear();
+    bookingIndex.clear();
+    statusIndex.clear();
+    load();
+    if (expiry) {
+        scheduleExpiry();
+    }
+}
+
+void BookingEngine::load() {
+    schedule->reset();
+    for (const auto& ws : manager->loadWorkstations()) {
+        if (!ownsWorkstation(workstationId(ws))) {
+            continue;
+        }
+        workstations.add(ws);
+        statusIndex.insert(workstationId(ws), baseOf(ws).getStatus());
+        schedule->putStation(ws);
+    }
+    vector<Booking> loaded = manager->loadBookings();
+    bookings.reserve(loaded.size());
+    for (const auto& b : loaded) {
+        if (!ownsWorkstation(b.getWorkstationId())) {
+            continue;
+        }
+        bookings.add(b);
+        bookingIndex.insert(b);
+        schedule->addBooking(b);
+    }
+    schedule->publish();
+}
+
+void BookingEngine::write(WriteBehindQueue::Mutation mutation) {
+    if (!writes) {
+        mutation(*manager);
+        return;
+    }
+    pendingWrites.push_back(writes->submit(std::move(mutation)));
+    // Не копить завершённые future бесконечно между flushWrites().
+    if (pendingWrites.size() >= 4096) {
+        collectWrites(false);
+    }
+}
+
+void BookingEngine::collectWrites(bool wait) {
+    size_t kept = 0;
+    for (future<void>& pending : pendingWrites) {
+        if (!wait && pending.wait_for(chrono::seconds(0)) != future_status::ready) {
+            pendingWrites[kept++] = std::move(pending);
+            continue;
+        }
+        try {
+            pending.get();
+        } catch (...) {
+            if (!writeError) {
+                writeError = current_exception();
+            }
+        }
+    }
+    pendingWrites.resize(kept);
+}
+
+void BookingEngine::flushWrites() {
+    if (!writes) {
+        return;
+    }
+    writes->flush();
+    collectWrites(true);
+    if (writeError) {
+        exception_ptr error = writeError;
+        writeError = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+// Без writeBehind изменение выполняется сразу в своей транзакции и
+// откатывается, если change вернул false: бронь удалил поток истечения, а
+// collectExpired() ещё не применил это к памяти. С writeBehind результат
+// не ждётся — такая бронь уйдёт из памяти при следующем applyExpired().
+bool BookingEngine::writeBooking(function<bool(BookingManager&)> change) {
+    if (writes) {
+        write([change](BookingManager& m) { change(m); });
+        return true;
+    }
+    UnitOfWork work(*manager);
+    if (!change(*manager)) {
+        return false;
+    }
+    work.commit();
+    return true;
+}
+
+void BookingEngine::applyExpired() {
+    if (!expiry) {
+        return;
+    }
+    for (PurgeResult& purged : expiry->drain()) {
+        applyPurge(purged);
+        collected.push_back(std::move(purged));
+    }
+}
+
+void BookingEngine::setStatus(Workstation& ws, WorkstationStatus newStatus) {
+    WorkstationStatus oldStatus = ws.getStatus();
+    ws.updateStatus(newStatus);
+    statusIndex.move(ws.getId(), oldStatus, newStatus);
+    schedule->setStatus(ws.getId(), newStatus);
+}
+
+void BookingEngine::removeBooking(const Booking& b) {
+    bookingIndex.erase(b);
+    bookings.erase(b.getBookingId());
+    schedule->removeBooking(b.getWorkstationId(), b.getBookingId());
+    if (expiry) {
+        expiry->cancel(b.getBookingId());
+    }
+}
+
+void BookingEngine::applyPurge(const PurgeResult& purged) {
+    for (int expiredId : purged.bookingIds) {
+        if (optional<Booking> expired = bookings.find(expiredId)) {
+            removeBooking(*expired);
+        }
+    }
+    long long nowInstant = localInstantNow();
+    for (int wsId : purged.releasedWorkstationIds) {
+        Workstation* ws = workstations.findBase(wsId);
+        // Бронь, добавленная после удаления в фоне, снова записала booked в базу.
+        if (ws && ws->getStatus() == WorkstationStatus::Booked && !bookings.hasActiveOnWorkstation(wsId, nowInstant)) {
+            setStatus(*ws, WorkstationStatus::Available);
+        }
+    }
+    schedule->publish();
+}
+
+EngineResult BookingEngine::checkInterval(int workstationId, Date day, TimeOfDay start, TimeOfDay end, int excludeBookingId) const {
+    EngineResult result;
+    if (!day.isValid() || start >= end) {
+        result.error = EngineError::InvalidInterval;
+    } else if (toLocalInstant(day, end) <= localInstantNow()) {
+        result.error = EngineError::InPast;
+    } else {
+        result.conflictingIds = bookingIndex.findOverlaps(workstationId, day, start, end, excludeBookingId);
+        if (!result.conflictingIds.empty()) {
+            result.error = EngineError::Conflict;
+        }
+    }
+    return result;
+}
+
+EngineResult BookingEngine::addWorkstation(const AnyWorkstation& ws) {
+    applyExpired();
+    EngineResult result;
+    int id = workstationId(ws);
+    if (workstations.contains(id)) {
+        result.error = EngineError::DuplicateWorkstation;
+        return result;
+    }
+    write([ws](BookingManager& m) { m.addWorkstation(ws); });
+    workstations.add(ws);
+    statusIndex.insert(id, baseOf(ws).getStatus());
+    schedule->putStation(ws);
+    schedule->publish();
+    return result;
+}
+
+EngineResult BookingEngine::deleteWorkstation(int id) {
+    applyExpired();
+    EngineResult result;
+    const Workstation* ws = workstations.findBase(id);
+    if (!ws) {
+        result.error = EngineError::WorkstationNotFound;
+        return result;
+    }
+    write([id](BookingManager& m) { m.deleteWorkstation(id); });
+    statusIndex.erase(id, ws->getStatus());
+    for (int bookingId : bookings.idsForWorkstation(id)) {
+        removeBooking(*bookings.find(bookingId));
+    }
+    workstations.erase(id);
+    schedule->removeStation(id);
+    schedule->publish();
+    return result;
+}
+
+EngineResult BookingEngine::setWorkstationStatus(int id, WorkstationStatus newStatus) {
+    applyExpired();
+    EngineResult result;
+    Workstation* ws = workstations.findBase(id);
+    if (!ws) {
+        result.error = EngineError::WorkstationNotFound;
+    } else if (!canTransition(ws->getStatus(), newStatus)) {
+        result.error = EngineError::InvalidTransition;
+    } else {
+        write([id, newStatus](BookingManager& m) { m.updateWorkstationStatus(id, newStatus); });
+        setStatus(*ws, newStatus);
+        schedule->publish();
+    }
+    return result;
+}
+
+EngineResult BookingEngine::checkBooking(const BookingRequest& request) const {
+    EngineResult result;
+    if (bookings.contains(request.bookingId)) {
+        result.error = EngineError::DuplicateBooking;
+    } else if (!workstations.contains(request.workstationId)) {
+        result.error = EngineError::WorkstationNotFound;
+    } else {
+        result = checkInterval(request.workstationId, request.bookingDate, request.startTime, request.endTime, request.bookingId);
+    }
+    return result;
+}
+
+EngineResult BookingEngine::addBooking(const BookingRequest& request) {
+    applyExpired();
+    EngineResult result = checkBooking(request);
+    if (!result.ok()) {
+        return result;
+    }
+
+    Workstation* ws = workstations.findBase(request.workstationId);
+    result.workstationBooked = ws->getStatus() != WorkstationStatus::Booked &&
+                               canTransition(ws->getStatus(), WorkstationStatus::Booked);
+
+    Booking b(request.bookingId, request.workstationId, manager->clientIdFor(request.clientName),
+              request.bookingDate, request.startTime, request.endTime);
+    // Уже booked станция тоже записывается: фоновый поток мог освободить её
+    // в базе после applyExpired(), и бронь осталась бы на available станции.
+    bool markBooked = result.workstationBooked || ws->getStatus() == WorkstationStatus::Booked;
+    write([b, markBooked](BookingManager& m) {
+        UnitOfWork work(m);
+        m.addBooking(b);
+        if (markBooked) {
+            m.updateWorkstationStatus(b.getWorkstationId(), WorkstationStatus::Booked);
+        }
+        work.commit();
+    });
+
+    bookings.add(b);
+    bookingIndex.insert(b);
+    schedule->addBooking(b);
+    if (expiry) {
+        expiry->schedule(b);
+    }
+    if (result.workstationBooked) {
+        setStatus(*ws, WorkstationStatus::Booked);
+    }
+    schedule->publish();
+    return result;
+}
+
+EngineResult BookingEngine::updateBooking(const BookingRequest& request) {
+    applyExpired();
+    EngineResult result;
+    optional<Booking> existing = bookings.find(request.bookingId);
+    if (!existing) {
+        result.error = EngineError::BookingNotFound;
+        return result;
+    }
+    if (!workstations.contains(request.workstationId)) {
+        result.error = EngineError::WorkstationNotFound;
+        return result;
+    }
+    result = checkInterval(request.workstationId, request.bookingDate, request.startTime, request.endTime, request.bookingId);
+    if (!result.ok()) {
+        return result;
+    }
+
+    int clientId = request.clientName.empty() ? existing->getClientId() : manager->clientIdFor(request.clientName);
+    Booking updated(request.bookingId, request.workstationId, clientId, request.bookingDate, request.startTime, request.endTime);
+    if (!writeBooking([updated](BookingManager& m) { return m.updateBooking(updated.getBookingId(), updated); })) {
+        result.error = EngineError::BookingNotFound;
+        return result;
+    }
+
+    bookingIndex.erase(*existing);
+    bookings.replace(updated);
+    bookingIndex.insert(updated);
+    schedule->removeBooking(existing->getWorkstationId(), existing->getBookingId());
+    schedule->addBooking(updated);
+    schedule->publish();
+    if (expiry) {
+        expiry->schedule(updated);
+    }
+    return result;
+}
+
+EngineResult BookingEngine::cancelBooking(int bookingId) {
+    applyExpired();
+    EngineResult result;
+    optional<Booking> existing = bookings.find(bookingId);
+    if (!existing) {
+        result.error = EngineError::BookingNotFound;
+        return result;
+    }
+
+    int wsId = existing->getWorkstationId();
+    Workstation* released = nullptr;
+    if (!bookings.hasActiveOnWorkstation(wsId, localInstantNow(), bookingId)) {
+        released = workstations.findBase(wsId);
+        if (released && released->getStatus() != WorkstationStatus::Booked) {
+            released = nullptr;
+        }
+    }
+
+    bool release = released != nullptr;
+    bool deleted = writeBooking([bookingId, wsId, release](BookingManager& m) {
+        if (!m.deleteBooking(bookingId)) {
+            return false;
+        }
+        if (release) {
+            m.updateWorkstationStatus(wsId, WorkstationStatus::Available);
+        }
+        return true;
+    });
+    if (!deleted) {
+        result.error = EngineError::BookingNotFound;
+        return result;
+    }
+
+    removeBooking(*existing);
+    if (released) {
+        setStatus(*released, WorkstationStatus::Available);
+        result.workstationReleased = true;
+    }
+    schedule->publish();
+    return result;
+}
+
+PurgeResult BookingEngine::purgeExpired(chrono::system_clock::time_point now) {
+    applyExpired();
+    // Столбцы броней в памяти совпадают с базой: если ни одна бронь не
+    // закончилась, транзакция удаления не нужна.
+    vector<int> expiredIds = bookings.idsEndedBy(localInstantNow(now));
+    if (expiredIds.empty()) {
+        return PurgeResult();
+    }
+    // Удаление идёт на соединении движка: отложенные записи должны быть уже в базе.
+    flushWrites();
+    // Раздел не трогает брони других разделов: их удаляют их движки.
+    PurgeResult purged = shardCount > 1 ? manager->expireBookings(expiredIds, now) : manager->purgeExpired(now);
+    applyPurge(purged);
+    return purged;
+}
+
+vector<PurgeResult> BookingEngine::collectExpired() {
+    applyExpired();
+    vector<PurgeResult> results = std::move(collected);
+    collected.clear();
+    return results;
+}
+
+vector<int> BookingEngine::workstationsWithStatus(WorkstationStatus status) const {
+    const auto& ids = statusIndex.idsWith(status);
+    vector<int> result(ids.begin(), ids.end());
+    sort(result.begin(), result.end());
+    return result;
+}
+
+vector<int> BookingEngine::premiumWithRatingAtLeast(int minRating) const {
+    vector<int> result = workstations.premiumWithRatingAtLeast(minRating);
+    sort(result.begin(), result.end());
+    return result;
+}
+
+vector<int> BookingEngine::bookingsForDay(Date day) const {
+    vector<int> result = bookings.idsForDay(day);
+    sort(result.begin(), result.end());
+    return result;
+}
+
+bool BookingEngine::isFree(int workstationId, Date day, TimeOfDay start, TimeOfDay end) const {
+    return bookingIndex.isFree(workstationId, day, start, end);
+}
+
+vector<int> BookingEngine::freeWorkstations(Date day, TimeOfDay start, TimeOfDay end) const {
+    vector<int> ids;
+    ids.reserve(workstations.size());
+    for (const auto& ws : workstations) {
+        ids.push_back(workstationId(ws));
+    }
+    sort(ids.begin(), ids.end());
+    return bookingIndex.findFreeStations(ids, day, start, end);
+}
@@ -0,0 +1,199 @@
+#ifndef BOOKING_ENGINE_H
+#define BOOKING_ENGINE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "booking.h"
+#include "booking_manager.h"
+#include "booking_store.h"
+#include "client_directory.h"
+#include "interval_index.h"
+#include "schedule_snapshot.h"
+#include "storage_config.h"
+#include "workstation.h"
+#include "write_behind_queue.h"
+#include "workstation_status.h"
+#include "workstation_store.h"
+
+class ExpiryScheduler;
+
+struct EngineConfig {
+    StorageConfig storage = StorageConfig::durableFast();
+    // Истечение броней по таймерам в фоновом потоке (ExpiryScheduler).
+    // Без него брони истекают только при вызове purgeExpired().
+    bool backgroundExpiry = true;
+    // Раздел движка (см. ShardedEngine): движок загружает и обслуживает
+    // только станции с shardOf(id, shardCount) == shardIndex и их брони.
+    unsigned shardCount = 1;
+    unsigned shardIndex = 0;
+    // Куда публиковать версии расписания; пусто — движок заводит свой
+    // SchedulePublisher. Общий публикатор переживает пересоздание движка.
+    std::shared_ptr<SchedulePublisher> schedule;
+    // Асинхронная запись (WriteBehindQueue): изменения сначала применяются в
+    // памяти, а в базу уходят пачками из фонового потока. Ошибку записи
+    // сообщает flushWrites(); после неё память уже не совпадает с базой.
+    bool writeBehind = false;
+    WriteBehindConfig writeBehindConfig;
+};
+
+constexpr unsigned shardOf(int workstationId, unsigned shardCount) {
+    return shardCount > 1 ? static_cast<unsigned>(workstationId) % shardCount : 0;
+}
+
+enum class EngineError : std::uint8_t {
+    None,
+    DuplicateWorkstation,
+    WorkstationNotFound,
+    InvalidTransition,
+    DuplicateBooking,
+    BookingNotFound,
+    InvalidInterval,  // начало не раньше конца или некорректная дата
+    InPast,
+    Conflict
+};
+
+constexpr const char* engineErrorName(EngineError error) {
+    switch (error) {
+        case EngineError::None: return "ok";
+        case EngineError::DuplicateWorkstation: return "duplicate_workstation";
+        case EngineError::WorkstationNotFound: return "workstation_not_found";
+        case EngineError::InvalidTransition: return "invalid_transition";
+        case EngineError::DuplicateBooking: return "duplicate_booking";
+        case EngineError::BookingNotFound: return "booking_not_found";
+        case EngineError::InvalidInterval: return "invalid_interval";
+        case EngineError::InPast: return "in_past";
+        case EngineError::Conflict: return "conflict";
+    }
+    return "unknown";
+}
+
+struct EngineResult {
+    EngineError error = EngineError::None;
+    std::vector<int> conflictingIds; // при Conflict
+    bool workstationBooked = false;   // addBooking перевёл станцию в booked
+    bool workstationReleased = false; // cancelBooking/deleteWorkstation освободили станцию
+
+    bool ok() const { return error == EngineError::None; }
+};
+
+struct BookingRequest {
+    int bookingId;
+    int workstationId;
+    std::string clientName; // в updateBooking пустое имя оставляет прежнего клиента
+    Date bookingDate;
+    TimeOfDay startTime;
+    TimeOfDay endTime;
+};
+
+// Вся логика бронирования без ввода-вывода: проверки, конфликты, статусы
+// станций и истечение броней. Данные держатся в памяти (хранилища станций и
+// броней, индексы интервалов и статусов), каждое изменение сначала
+// фиксируется в базе, затем применяется в памяти (с writeBehind — сначала
+// в памяти, запись в базу догоняет). Ошибки предметной области
+// возвращаются в EngineResult, ошибки базы данных — исключениями.
+// Объект не потокобезопасен: все вызовы — из одного потока. Исключение —
+// readSchedule(): после каждого изменения движок публикует неизменяемую
+// версию расписания, и её можно читать из любых потоков без блокировок.
+class BookingEngine {
+private:
+    std::unique_ptr<BookingManager> manager;
+    WorkstationStore workstations;
+    BookingStore bookings;
+    IntervalIndex bookingIndex;
+    WorkstationStatusIndex statusIndex;
+    std::unique_ptr<ExpiryScheduler> expiry;
+    unsigned shardCount;
+    unsigned shardIndex;
+    std::shared_ptr<SchedulePublisher> schedule;
+    std::unique_ptr<WriteBehindQueue> writes;
+    std::vector<std::future<void>> pendingWrites;
+    std::exception_ptr writeError;
+    std::vector<PurgeResult> collected; // применено в памяти, ещё не отдано collectExpired()
+
+    void load();
+    void scheduleExpiry();
+    // Изменение базы: сразу на соединении движка или в очередь writes.
+    void write(WriteBehindQueue::Mutation mutation);
+    // Забирает завершённые записи (все, если wait), запоминая первую ошибку.
+    void collectWrites(bool wait);
+    // Изменение брони в базе; false, если брони там уже нет (см. writeBooking в .cpp).
+    bool writeBooking(std::function<bool(BookingManager&)> change);
+    // Применяет в памяти то, что удалил фоновый поток истечения; вызывается
+    // в начале каждого изменения, чтобы оно не опиралось на устаревшие статусы.
+    void applyExpired();
+    void setStatus(Workstation& ws, WorkstationStatus newStatus);
+    void removeBooking(const Booking& b);
+    void applyPurge(const PurgeResult& purged);
+    EngineResult checkInterval(int workstationId, Date day, TimeOfDay start, TimeOfDay end, int excludeBookingId) const;
+
+public:
+    explicit BookingEngine(const EngineConfig& config = EngineConfig());
+    ~BookingEngine();
+    BookingEngine(const BookingEngine&) = delete;
+    BookingEngine& operator=(const BookingEngine&) = delete;
+
+    // Станции.
+    EngineResult addWorkstation(const AnyWorkstation& ws);
+    // Удаляет станцию вместе с её бронями.
+    EngineResult deleteWorkstation(int id);
+    EngineResult setWorkstationStatus(int id, WorkstationStatus newStatus);
+
+    // Брони. checkBooking — проверки addBooking без записи: дубликат ID,
+    // станция, интервал и конфликты.
+    EngineResult checkBooking(const BookingRequest& request) const;
+    EngineResult addBooking(const BookingRequest& request);
+    EngineResult updateBooking(const BookingRequest& request);
+    EngineResult cancelBooking(int bookingId);
+
+    // Истечение. purgeExpired — один запрос по индексу (например, при запуске;
+    // раздел ShardedEngine удаляет только свои брони);
+    // collectExpired забирает то, что уже удалил фоновый поток (в том числе
+    // применённое в памяти при предыдущих изменениях).
+    PurgeResult purgeExpired(std::chrono::system_clock::time_point now = std::chrono::system_clock::now());
+    std::vector<PurgeResult> collectExpired();
+
+    // Загружает станции и брони из базы заново: после неудачного COMMIT
+    // память движка уже не совпадает с базой. С writeBehind сначала
+    // дожидается очереди, её ошибки отбрасываются.
+    void reload();
+
+    // Запросы.
+    const WorkstationStore& getWorkstations() const { return workstations; }
+    const BookingStore& getBookings() const { return bookings; }
+    const ClientDirectory& getClients() const { return manager->getClients(); }
+    const AnyWorkstation* findWorkstation(int id) const { return workstations.find(id); }
+    std::optional<Booking> findBooking(int id) const { return bookings.find(id); }
+    std::size_t countWithStatus(WorkstationStatus status) const { return statusIndex.count(status); }
+    // ID по возрастанию.
+    std::vector<int> workstationsWithStatus(WorkstationStatus status) const;
+    std::vector<int> premiumWithRatingAtLeast(int minRating) const;
+    std::vector<int> bookingsForDay(Date day) const;
+    bool isFree(int workstationId, Date day, TimeOfDay start, TimeOfDay end) const;
+    // Все станции, свободные в [start, end) дня day, по возрастанию ID:
+    // одна маска интервала на битовые карты всех станций.
+    std::vector<int> freeWorkstations(Date day, TimeOfDay start, TimeOfDay end) const;
+
+    // Из любого потока: последняя опубликованная версия расписания.
+    SchedulePublisher::Reader readSchedule() const { return schedule->read(); }
+    const std::shared_ptr<SchedulePublisher>& getSchedulePublisher() const { return schedule; }
+
+    bool ownsWorkstation(int id) const { return shardOf(id, shardCount) == shardIndex; }
+
+    // Соединение движка: например, для UnitOfWork вокруг пачки операций.
+    // При writeBehind изменения пишет не оно: вместо UnitOfWork — flushWrites().
+    BookingManager& getManager() { return *manager; }
+    bool writesBehind() const { return writes != nullptr; }
+    // Ждёт записи всех изменений в базу; первую ошибку записи бросает.
+    // Без writeBehind ничего не делает.
+    void flushWrites();
+};
+
+#endif // BOOKING_ENGINE_H
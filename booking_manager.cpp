@@ -1,17 +1,21 @@
 #include "booking_manager.h"
 #include "workstation.h"
 #include "booking.h"
+#include "statement_cache.h"
+#include "civil_date.h"
 #include <sqlite3.h>
 #include <stdexcept>
 #include <sstream>
 #include <vector>
 #include <string>
 #include <iostream>
+#include <iomanip>
+#include <algorithm>
 
 using namespace std;
 
-BookingManager::BookingManager() : db(nullptr) {
-    int rc = sqlite3_open("booking.db", &db);
+BookingManager::BookingManager(const StorageConfig& _config) : db(nullptr), config(_config) {
+    int rc = sqlite3_open_v2(config.path.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
     if (rc) {
         string errMsgStr = db ? sqlite3_errmsg(db) : "не удалось получить сообщение об ошибке sqlite";
         if (db) sqlite3_close(db);
@@ -19,8 +23,13 @@ BookingManager::BookingManager() : db(nullptr) {
         throw runtime_error("Не удалось открыть базу данных: " + errMsgStr);
     }
     try {
+        applyStorageConfig();
         initializeDatabase();
+        statements = make_unique<StatementCache>(db);
+        loadClients();
     } catch (...) {
+        // Подготовленные запросы кэша держат соединение: без них sqlite3_close вернёт SQLITE_BUSY.
+        statements.reset();
         sqlite3_close(db);
         db = nullptr;
         throw;
@@ -28,196 +37,646 @@ BookingManager::BookingManager() : db(nullptr) {
 }
 
 BookingManager::~BookingManager() {
+    statements.reset();
     if (db) {
         sqlite3_close(db);
     }
 }
 
-void BookingManager::initializeDatabase() {
-    const char* sql1 = "CREATE TABLE IF NOT EXISTS Workstations (id INTEGER PRIMARY KEY, name TEXT, status TEXT);";
-    const char* sql2 = "CREATE TABLE IF NOT EXISTS Bookings (bookingId INTEGER PRIMARY KEY, workstationId INTEGER, clientName TEXT, bookingDate TEXT, startHour INTEGER, startMinute INTEGER, endHour INTEGER, endMinute INTEGER);";
-    char* errMsg = nullptr;
-    int rc = sqlite3_exec(db, sql1, 0, 0, &errMsg);
-    if (rc != SQLITE_OK) {
-        string err = errMsg ? errMsg : "неизвестная ошибка sqlite";
-        sqlite3_free(errMsg);
-        throw runtime_error("Ошибка SQL при создании таблицы Workstations: " + err);
-    }
-    rc = sqlite3_exec(db, sql2, 0, 0, &errMsg);
-    if (rc != SQLITE_OK) {
-        string err = errMsg ? errMsg : "неизвестная ошибка sqlite";
-        sqlite3_free(errMsg);
-        throw runtime_error("Ошибка SQL при создании таблицы Bookings: " + err);
-    }
+bool BookingManager::inTransaction() const {
+    return !sqlite3_get_autocommit(db);
+}
+
+StatementCacheStats BookingManager::getStatementCacheStats() const {
+    return statements->getStats();
 }
 
-vector<Workstation> BookingManager::loadWorkstations() {
-    vector<Workstation> result;
-    const char* sql = "SELECT id, name, status FROM Workstations;";
+int BookingManager::readSchemaVersion() {
     sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) != SQLITE_OK) {
         string errMsgStr = sqlite3_errmsg(db);
         sqlite3_finalize(stmt);
-        throw runtime_error("Ошибка подготовки запроса для загрузки рабочих станций: " + errMsgStr);
-    }
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const unsigned char* nameText = sqlite3_column_text(stmt, 1);
-        const unsigned char* statusText = sqlite3_column_text(stmt, 2);
-        string name = nameText ? reinterpret_cast<const char*>(nameText) : "";
-        string status = statusText ? reinterpret_cast<const char*>(statusText) : "";
-        result.emplace_back(id, name, status);
+        throw runtime_error("Не удалось прочитать версию схемы: " + errMsgStr);
     }
+    int version = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
     sqlite3_finalize(stmt);
-    return result;
+    return version;
 }
 
-vector<Booking> BookingManager::loadBookings() {
-    vector<Booking> result;
-    const char* sql = "SELECT bookingId, workstationId, clientName, bookingDate, startHour, startMinute, endHour, endMinute FROM Bookings;";
+bool BookingManager::queryHasRow(const char* sql, const string& context) {
     sqlite3_stmt* stmt = nullptr;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
         string errMsgStr = sqlite3_errmsg(db);
         sqlite3_finalize(stmt);
-        throw runtime_error("Ошибка подготовки запроса для загрузки бронирований: " + errMsgStr);
-    }
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int bookingId = sqlite3_column_int(stmt, 0);
-        int workstationId = sqlite3_column_int(stmt, 1);
-        const unsigned char* clientText = sqlite3_column_text(stmt, 2);
-        const unsigned char* dateText = sqlite3_column_text(stmt, 3);
-        int startHour = sqlite3_column_int(stmt, 4);
-        int startMinute = sqlite3_column_int(stmt, 5);
-        int endHour = sqlite3_column_int(stmt, 6);
-        int endMinute = sqlite3_column_int(stmt, 7);
-        string clientName = clientText ? reinterpret_cast<const char*>(clientText) : "";
-        string bookingDate = dateText ? reinterpret_cast<const char*>(dateText) : "";
-        Time start = { startHour, startMinute };
-        Time end = { endHour, endMinute };
-        result.emplace_back(bookingId, workstationId, clientName, bookingDate, start, end);
+        throw runtime_error(context + ": " + errMsgStr);
     }
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
     sqlite3_finalize(stmt);
+    return found;
+}
+
+bool BookingManager::hasLegacyBookingsTable() {
+    return queryHasRow("SELECT 1 FROM pragma_table_info('Bookings') WHERE name = 'bookingDate';",
+                       "Не удалось прочитать структуру таблицы Bookings");
+}
+
+// Версия 1 хранила дату текстом DD-MM-YYYY и время парами час/минута.
+// Версия 2 хранит номер дня от 01-01-1970 и минуты от начала суток.
+void BookingManager::migrateBookingsToV2() {
+    execSql("CREATE TABLE Bookings_v2 (bookingId INTEGER PRIMARY KEY, workstationId INTEGER NOT NULL, clientName TEXT, "
+            "bookingDay INTEGER NOT NULL, startMinute INTEGER NOT NULL, endMinute INTEGER NOT NULL);",
+            "Ошибка миграции таблицы Bookings");
+    execSql("INSERT INTO Bookings_v2 (bookingId, workstationId, clientName, bookingDay, startMinute, endMinute) "
+            "SELECT bookingId, workstationId, clientName, "
+            "CAST(julianday(substr(bookingDate, 7, 4) || '-' || substr(bookingDate, 4, 2) || '-' || substr(bookingDate, 1, 2)) - 2440587.5 AS INTEGER), "
+            "startHour * 60 + startMinute, endHour * 60 + endMinute FROM Bookings;",
+            "Ошибка миграции таблицы Bookings (некорректная дата в старых данных?)");
+    execSql("DROP TABLE Bookings;", "Ошибка миграции таблицы Bookings");
+    execSql("ALTER TABLE Bookings_v2 RENAME TO Bookings;", "Ошибка миграции таблицы Bookings");
+}
+
+bool BookingManager::hasLegacyWorkstationsTable() {
+    return queryHasRow("SELECT 1 FROM pragma_table_info('Workstations') WHERE name = 'status' AND type = 'TEXT';",
+                       "Не удалось прочитать структуру таблицы Workstations");
+}
+
+// Версии 1 и 2 хранили статус станции текстом, версия 3 — числом WorkstationStatus.
+void BookingManager::migrateWorkstationsToV3() {
+    execSql("CREATE TABLE Workstations_v3 (id INTEGER PRIMARY KEY, name TEXT, status INTEGER NOT NULL DEFAULT 0);",
+            "Ошибка миграции таблицы Workstations");
+    execSql("INSERT INTO Workstations_v3 (id, name, status) "
+            "SELECT id, name, CASE status WHEN 'booked' THEN 1 WHEN 'maintenance' THEN 2 ELSE 0 END FROM Workstations;",
+            "Ошибка миграции таблицы Workstations");
+    execSql("DROP TABLE Workstations;", "Ошибка миграции таблицы Workstations");
+    execSql("ALTER TABLE Workstations_v3 RENAME TO Workstations;", "Ошибка миграции таблицы Workstations");
+}
+
+// Версия 4 добавляет вид станции (WorkstationKind) и рейтинг премиум-станций.
+void BookingManager::migrateWorkstationsToV4() {
+    if (queryHasRow("SELECT 1 FROM pragma_table_info('Workstations') WHERE name = 'kind';",
+                    "Не удалось прочитать структуру таблицы Workstations")) {
+        return;
+    }
+    execSql("ALTER TABLE Workstations ADD COLUMN kind INTEGER NOT NULL DEFAULT 0;", "Ошибка миграции таблицы Workstations");
+    execSql("ALTER TABLE Workstations ADD COLUMN rating INTEGER NOT NULL DEFAULT 0;", "Ошибка миграции таблицы Workstations");
+}
+
+bool BookingManager::hasClientNameColumn() {
+    return queryHasRow("SELECT 1 FROM pragma_table_info('Bookings') WHERE name = 'clientName';",
+                       "Не удалось прочитать структуру таблицы Bookings");
+}
+
+// Версии 1–4 хранили имя клиента в каждой брони. Версия 5 выносит имена
+// в таблицу Clients, а бронь ссылается на клиента по ID.
+void BookingManager::migrateBookingsToV5() {
+    execSql("INSERT OR IGNORE INTO Clients (name) SELECT DISTINCT COALESCE(clientName, '') FROM Bookings;",
+            "Ошибка миграции таблицы Clients");
+    execSql("CREATE TABLE Bookings_v5 (bookingId INTEGER PRIMARY KEY, workstationId INTEGER NOT NULL, "
+            "clientId INTEGER NOT NULL REFERENCES Clients (id), "
+            "bookingDay INTEGER NOT NULL, startMinute INTEGER NOT NULL, endMinute INTEGER NOT NULL);",
+            "Ошибка миграции таблицы Bookings");
+    execSql("INSERT INTO Bookings_v5 (bookingId, workstationId, clientId, bookingDay, startMinute, endMinute) "
+            "SELECT b.bookingId, b.workstationId, c.id, b.bookingDay, b.startMinute, b.endMinute "
+            "FROM Bookings b JOIN Clients c ON c.name = COALESCE(b.clientName, '');",
+            "Ошибка миграции таблицы Bookings");
+    execSql("DROP TABLE Bookings;", "Ошибка миграции таблицы Bookings");
+    execSql("ALTER TABLE Bookings_v5 RENAME TO Bookings;", "Ошибка миграции таблицы Bookings");
+}
+
+void BookingManager::initializeDatabase() {
+    UnitOfWork work(*this);
+    execSql("CREATE TABLE IF NOT EXISTS Clients (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE);",
+            "Ошибка SQL при создании таблицы Clients");
+    execSql("CREATE TABLE IF NOT EXISTS Workstations (id INTEGER PRIMARY KEY, name TEXT, status INTEGER NOT NULL DEFAULT 0, "
+            "kind INTEGER NOT NULL DEFAULT 0, rating INTEGER NOT NULL DEFAULT 0);",
+            "Ошибка SQL при создании таблицы Workstations");
+
+    int version = readSchemaVersion();
+    if (version > kSchemaVersion) {
+        throw runtime_error("База данных создана более новой версией программы (схема " + to_string(version) + ")");
+    }
+    if (version < 2 && hasLegacyBookingsTable()) {
+        migrateBookingsToV2();
+    }
+    if (version < 3 && hasLegacyWorkstationsTable()) {
+        migrateWorkstationsToV3();
+    }
+    if (version < 4) {
+        migrateWorkstationsToV4();
+    }
+    if (version < 5 && hasClientNameColumn()) {
+        migrateBookingsToV5();
+    }
+
+    execSql("CREATE TABLE IF NOT EXISTS Bookings (bookingId INTEGER PRIMARY KEY, workstationId INTEGER NOT NULL, "
+            "clientId INTEGER NOT NULL REFERENCES Clients (id), bookingDay INTEGER NOT NULL, startMinute INTEGER NOT NULL, endMinute INTEGER NOT NULL);",
+            "Ошибка SQL при создании таблицы Bookings");
+    execSql("CREATE INDEX IF NOT EXISTS idx_bookings_station_day ON Bookings (workstationId, bookingDay, startMinute);",
+            "Ошибка SQL при создании индекса Bookings");
+    execSql("CREATE INDEX IF NOT EXISTS idx_bookings_day_end ON Bookings (bookingDay, endMinute);",
+            "Ошибка SQL при создании индекса Bookings");
+    string setVersion = "PRAGMA user_version = " + to_string(kSchemaVersion) + ";";
+    execSql(setVersion.c_str(), "Не удалось записать версию схемы");
+    work.commit();
+}
+
+void BookingManager::loadClients() {
+    CachedStatement stmt(*statements, "SELECT id, name FROM Clients;");
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для загрузки клиентов: " + string(sqlite3_errmsg(db)));
+    }
+    clients.clear();
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+        const unsigned char* name = sqlite3_column_text(stmt.get(), 1);
+        clients.add(sqlite3_column_int(stmt.get(), 0), name ? reinterpret_cast<const char*>(name) : "");
+    }
+    if (rc != SQLITE_DONE) {
+        throw runtime_error("Ошибка чтения клиентов: " + string(sqlite3_errmsg(db)));
+    }
+}
+
+int BookingManager::clientIdFor(const string& name) {
+    int id;
+    if (clients.find(name, id)) {
+        return id;
+    }
+    // DO UPDATE вместо DO NOTHING, чтобы RETURNING вернул ID и для клиента,
+    // которого уже добавило другое соединение.
+    const char* sql = "INSERT INTO Clients (name) VALUES (?) ON CONFLICT (name) DO UPDATE SET name = excluded.name RETURNING id;";
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для добавления клиента: " + string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_text(stmt.get(), 1, name.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+        throw runtime_error("Ошибка выполнения запроса для добавления клиента: " + string(sqlite3_errmsg(db)));
+    }
+    id = sqlite3_column_int(stmt.get(), 0);
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        throw runtime_error("Ошибка выполнения запроса для добавления клиента: " + string(sqlite3_errmsg(db)));
+    }
+    clients.add(id, name);
+    if (transactionDepth > 0) {
+        pendingClients.emplace_back(transactionDepth, id);
+    }
+    return id;
+}
+
+void BookingManager::applyStorageConfig() {
+    sqlite3_busy_timeout(db, config.busyTimeoutMs);
+
+    static const char* const synchronousNames[] = { "OFF", "NORMAL", "FULL", "EXTRA" };
+    string pragmas = string("PRAGMA journal_mode = ") + (config.walMode ? "WAL" : "DELETE") + ";"
+                   + "PRAGMA synchronous = " + synchronousNames[static_cast<int>(config.synchronous)] + ";"
+                   + "PRAGMA cache_size = -" + to_string(config.cacheSizeKiB) + ";"
+                   + "PRAGMA mmap_size = " + to_string(config.mmapSizeBytes) + ";"
+                   + "PRAGMA temp_store = MEMORY;";
+    execSql(pragmas.c_str(), "Не удалось применить настройки хранилища");
+}
+
+void BookingManager::execSql(const char* sql, const string& context) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, 0, 0, &errMsg) != SQLITE_OK) {
+        string err = errMsg ? errMsg : "неизвестная ошибка sqlite";
+        sqlite3_free(errMsg);
+        throw runtime_error(context + ": " + err);
+    }
+}
+
+void BookingManager::beginTransaction() {
+    if (transactionDepth == 0) {
+        execSql("BEGIN IMMEDIATE;", "Не удалось начать транзакцию");
+    } else {
+        string sql = "SAVEPOINT sp" + to_string(transactionDepth) + ";";
+        execSql(sql.c_str(), "Не удалось создать точку сохранения");
+    }
+    ++transactionDepth;
+}
+
+void BookingManager::commitTransaction() {
+    if (transactionDepth == 0 || sqlite3_get_autocommit(db)) {
+        transactionDepth = 0;
+        settlePendingClients(true);
+        throw runtime_error("Не удалось зафиксировать транзакцию: транзакция уже отменена");
+    }
+    if (transactionDepth == 1) {
+        execSql("COMMIT;", "Не удалось зафиксировать транзакцию");
+    } else {
+        string sql = "RELEASE sp" + to_string(transactionDepth - 1) + ";";
+        execSql(sql.c_str(), "Не удалось освободить точку сохранения");
+    }
+    --transactionDepth;
+    settlePendingClients(false);
+}
+
+// Вызывается после изменения transactionDepth. При фиксации клиенты
+// переходят на внешний уровень, при откате — забываются: следующий
+// clientIdFor найдёт или добавит их заново.
+void BookingManager::settlePendingClients(bool rolledBack) noexcept {
+    size_t kept = 0;
+    for (auto [depth, id] : pendingClients) {
+        if (depth > transactionDepth) {
+            if (rolledBack) {
+                clients.erase(id);
+                continue;
+            }
+            depth = transactionDepth;
+        }
+        if (transactionDepth > 0) {
+            pendingClients[kept++] = { depth, id };
+        }
+    }
+    pendingClients.resize(kept);
+}
+
+void BookingManager::rollbackTransaction() noexcept {
+    if (transactionDepth == 0) {
+        return;
+    }
+    --transactionDepth;
+    if (sqlite3_get_autocommit(db)) {
+        // SQLite уже откатил всю транзакцию сам (ошибка ввода-вывода, нехватка памяти).
+        transactionDepth = 0;
+        settlePendingClients(true);
+        return;
+    }
+    if (transactionDepth == 0) {
+        sqlite3_exec(db, "ROLLBACK;", 0, 0, nullptr);
+    } else {
+        string sql = "ROLLBACK TO sp" + to_string(transactionDepth) + "; RELEASE sp" + to_string(transactionDepth) + ";";
+        sqlite3_exec(db, sql.c_str(), 0, 0, nullptr);
+    }
+    settlePendingClients(true);
+}
+
+UnitOfWork::UnitOfWork(BookingManager& _manager) : manager(_manager), active(false) {
+    manager.beginTransaction();
+    active = true;
+}
+
+UnitOfWork::~UnitOfWork() {
+    rollback();
+}
+
+void UnitOfWork::commit() {
+    if (!active) {
+        throw runtime_error("Единица работы уже завершена");
+    }
+    active = false;
+    try {
+        manager.commitTransaction();
+    } catch (...) {
+        manager.rollbackTransaction();
+        throw;
+    }
+}
+
+void UnitOfWork::rollback() noexcept {
+    if (active) {
+        active = false;
+        manager.rollbackTransaction();
+    }
+}
+
+WorkstationCursor BookingManager::openWorkstations() {
+    const char* sql = "SELECT id, name, status, kind, rating FROM Workstations;";
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для загрузки рабочих станций: " + string(sqlite3_errmsg(db)));
+    }
+    return WorkstationCursor(move(stmt));
+}
+
+BookingCursor BookingManager::openBookings() {
+    const char* sql = "SELECT bookingId, workstationId, clientId, bookingDay, startMinute, endMinute FROM Bookings;";
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для загрузки бронирований: " + string(sqlite3_errmsg(db)));
+    }
+    return BookingCursor(move(stmt));
+}
+
+void BookingManager::forEachWorkstation(const function<bool(const WorkstationRow&)>& visit) {
+    WorkstationCursor cursor = openWorkstations();
+    while (cursor.next() && visit(cursor.row())) {
+    }
+}
+
+void BookingManager::forEachBooking(const function<bool(const BookingRow&)>& visit) {
+    BookingCursor cursor = openBookings();
+    while (cursor.next() && visit(cursor.row())) {
+    }
+}
+
+static Booking toBooking(const BookingRow& row) {
+    return Booking(row.bookingId, row.workstationId, row.clientId, row.bookingDate, row.startTime, row.endTime);
+}
+
+static vector<Booking> collectBookings(BookingCursor& cursor) {
+    vector<Booking> result;
+    while (cursor.next()) {
+        result.push_back(toBooking(cursor.row()));
+    }
     return result;
 }
 
-void BookingManager::addWorkstation(const Workstation& ws) {
-    const char* sql = "INSERT INTO Workstations (id, name, status) VALUES (?, ?, ?);";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        string errMsgStr = sqlite3_errmsg(db);
-        sqlite3_finalize(stmt);
-        throw runtime_error("Ошибка подготовки запроса для добавления станции: " + errMsgStr);
+vector<AnyWorkstation> BookingManager::loadWorkstations() {
+    vector<AnyWorkstation> result;
+    WorkstationCursor cursor = openWorkstations();
+    while (cursor.next()) {
+        const WorkstationRow& row = cursor.row();
+        if (row.kind == WorkstationKind::Premium) {
+            result.emplace_back(SpecialWorkstation(row.id, string(row.name), row.status, row.rating));
+        } else {
+            result.emplace_back(Workstation(row.id, string(row.name), row.status));
+        }
     }
-    sqlite3_bind_int(stmt, 1, ws.getId());
-    sqlite3_bind_text(stmt, 2, ws.getName().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, "available", -1, SQLITE_TRANSIENT);
+    return result;
+}
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        string errMsgStr = sqlite3_errmsg(db);
-        sqlite3_finalize(stmt);
-        throw runtime_error("Ошибка выполнения запроса для добавления станции: " + errMsgStr);
+vector<Booking> BookingManager::loadBookings() {
+    BookingCursor cursor = openBookings();
+    return collectBookings(cursor);
+}
+
+vector<Booking> BookingManager::loadBookingsForDay(Date day) {
+    const char* sql = "SELECT bookingId, workstationId, clientId, bookingDay, startMinute, endMinute FROM Bookings "
+                      "WHERE bookingDay = ? ORDER BY workstationId, startMinute;";
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для загрузки бронирований за день: " + string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_int(stmt.get(), 1, day.days());
+    BookingCursor cursor(move(stmt));
+    return collectBookings(cursor);
+}
+
+vector<Booking> BookingManager::loadBookingsForWorkstation(int workstationId, Date fromDay, Date toDay) {
+    const char* sql = "SELECT bookingId, workstationId, clientId, bookingDay, startMinute, endMinute FROM Bookings "
+                      "WHERE workstationId = ? AND bookingDay BETWEEN ? AND ? ORDER BY bookingDay, startMinute;";
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для загрузки бронирований станции: " + string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_int(stmt.get(), 1, workstationId);
+    sqlite3_bind_int(stmt.get(), 2, fromDay.days());
+    sqlite3_bind_int(stmt.get(), 3, toDay.days());
+    BookingCursor cursor(move(stmt));
+    return collectBookings(cursor);
+}
+
+vector<Booking> BookingManager::loadActiveBookings(chrono::system_clock::time_point now) {
+    const char* sql = "SELECT bookingId, workstationId, clientId, bookingDay, startMinute, endMinute FROM Bookings "
+                      "WHERE bookingDay >= ?1 AND (bookingDay > ?1 OR endMinute > ?2) ORDER BY bookingDay, startMinute;";
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для загрузки активных бронирований: " + string(sqlite3_errmsg(db)));
+    }
+    LocalDateTime local = toLocalDateTime(now);
+    sqlite3_bind_int(stmt.get(), 1, local.date.days());
+    sqlite3_bind_int(stmt.get(), 2, local.time.totalMinutes());
+    BookingCursor cursor(move(stmt));
+    return collectBookings(cursor);
+}
+
+bool BookingManager::insertRow(const AnyWorkstation& ws, string& error) {
+    const char* sql = "INSERT INTO Workstations (id, name, status, kind, rating) VALUES (?, ?, ?, ?, ?);";
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для добавления станции: " + string(sqlite3_errmsg(db)));
+    }
+    const Workstation& base = baseOf(ws);
+    sqlite3_bind_int(stmt.get(), 1, base.getId());
+    sqlite3_bind_text(stmt.get(), 2, base.getName().c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt.get(), 3, static_cast<int>(base.getStatus()));
+    sqlite3_bind_int(stmt.get(), 4, static_cast<int>(kindOf(ws)));
+    sqlite3_bind_int(stmt.get(), 5, ratingOf(ws));
+
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+    return true;
+}
+
+void BookingManager::addWorkstation(const AnyWorkstation& ws) {
+    string error;
+    if (!insertRow(ws, error)) {
+        throw runtime_error("Ошибка выполнения запроса для добавления станции: " + error);
     }
-    sqlite3_finalize(stmt);
 }
 
 void BookingManager::deleteWorkstation(int id) {
+    UnitOfWork work(*this);
+    {
+        const char* sql = "DELETE FROM Bookings WHERE workstationId = ?;";
+        CachedStatement stmt(*statements, sql);
+        if (!stmt) {
+            throw runtime_error("Ошибка подготовки запроса для удаления броней станции: " + string(sqlite3_errmsg(db)));
+        }
+        sqlite3_bind_int(stmt.get(), 1, id);
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+            throw runtime_error("Ошибка выполнения запроса для удаления броней станции: " + string(sqlite3_errmsg(db)));
+        }
+    }
     const char* sql = "DELETE FROM Workstations WHERE id = ?;";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-         string errMsgStr = sqlite3_errmsg(db);
-         sqlite3_finalize(stmt);
-         throw runtime_error("Ошибка подготовки запроса для удаления станции: " + errMsgStr);
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для удаления станции: " + string(sqlite3_errmsg(db)));
     }
-    sqlite3_bind_int(stmt, 1, id);
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        string errMsgStr = sqlite3_errmsg(db);
-        sqlite3_finalize(stmt);
-        throw runtime_error("Ошибка выполнения запроса для удаления станции: " + errMsgStr);
+    sqlite3_bind_int(stmt.get(), 1, id);
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        throw runtime_error("Ошибка выполнения запроса для удаления станции: " + string(sqlite3_errmsg(db)));
     }
-    sqlite3_finalize(stmt);
+    work.commit();
 }
 
-void BookingManager::updateWorkstationStatus(int id, const string& newStatus) {
+void BookingManager::updateWorkstationStatus(int id, WorkstationStatus newStatus) {
     const char* sql = "UPDATE Workstations SET status = ? WHERE id = ?;";
-     sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-         string errMsgStr = sqlite3_errmsg(db);
-         sqlite3_finalize(stmt);
-         throw runtime_error("Ошибка подготовки запроса для обновления статуса станции: " + errMsgStr);
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для обновления статуса станции: " + string(sqlite3_errmsg(db)));
     }
-    sqlite3_bind_text(stmt, 1, newStatus.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 2, id);
-     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        string errMsgStr = sqlite3_errmsg(db);
-        sqlite3_finalize(stmt);
-        throw runtime_error("Ошибка выполнения запроса для обновления статуса станции: " + errMsgStr);
+    sqlite3_bind_int(stmt.get(), 1, static_cast<int>(newStatus));
+    sqlite3_bind_int(stmt.get(), 2, id);
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        throw runtime_error("Ошибка выполнения запроса для обновления статуса станции: " + string(sqlite3_errmsg(db)));
     }
-    sqlite3_finalize(stmt);
+}
+
+bool BookingManager::insertRow(const Booking& b, string& error) {
+    if (!b.hasValidDate()) {
+        error = "некорректная дата бронирования";
+        return false;
+    }
+    const char* sql = "INSERT INTO Bookings (bookingId, workstationId, clientId, bookingDay, startMinute, endMinute) VALUES (?, ?, ?, ?, ?, ?);";
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для добавления брони: " + string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_int(stmt.get(), 1, b.getBookingId());
+    sqlite3_bind_int(stmt.get(), 2, b.getWorkstationId());
+    sqlite3_bind_int(stmt.get(), 3, b.getClientId());
+    sqlite3_bind_int(stmt.get(), 4, b.getBookingDate().days());
+    sqlite3_bind_int(stmt.get(), 5, b.getStartTime().totalMinutes());
+    sqlite3_bind_int(stmt.get(), 6, b.getEndTime().totalMinutes());
+
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+    return true;
 }
 
 void BookingManager::addBooking(const Booking& b) {
-    const char* sql = "INSERT INTO Bookings (bookingId, workstationId, clientName, bookingDate, startHour, startMinute, endHour, endMinute) VALUES (?, ?, ?, ?, ?, ?, ?, ?);";
-     sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-         string errMsgStr = sqlite3_errmsg(db);
-         sqlite3_finalize(stmt);
-         throw runtime_error("Ошибка подготовки запроса для добавления брони: " + errMsgStr);
-    }
-    sqlite3_bind_int(stmt, 1, b.getBookingId());
-    sqlite3_bind_int(stmt, 2, b.getWorkstationId());
-    sqlite3_bind_text(stmt, 3, b.getClientName().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, b.getBookingDate().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 5, b.getStartTime().hour);
-    sqlite3_bind_int(stmt, 6, b.getStartTime().minute);
-    sqlite3_bind_int(stmt, 7, b.getEndTime().hour);
-    sqlite3_bind_int(stmt, 8, b.getEndTime().minute);
-
-     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        string errMsgStr = sqlite3_errmsg(db);
-        sqlite3_finalize(stmt);
-        throw runtime_error("Ошибка выполнения запроса для добавления брони: " + errMsgStr);
+    string error;
+    if (!insertRow(b, error)) {
+        throw runtime_error("Ошибка выполнения запроса для добавления брони: " + error);
     }
-    sqlite3_finalize(stmt);
 }
 
-void BookingManager::deleteBooking(int bookingId) {
+bool BookingManager::deleteBooking(int bookingId) {
     const char* sql = "DELETE FROM Bookings WHERE bookingId = ?;";
-     sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-         string errMsgStr = sqlite3_errmsg(db);
-         sqlite3_finalize(stmt);
-         throw runtime_error("Ошибка подготовки запроса для удаления брони: " + errMsgStr);
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для удаления брони: " + string(sqlite3_errmsg(db)));
     }
-     sqlite3_bind_int(stmt, 1, bookingId);
-     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        string errMsgStr = sqlite3_errmsg(db);
-        sqlite3_finalize(stmt);
-        throw runtime_error("Ошибка выполнения запроса для удаления брони: " + errMsgStr);
+    sqlite3_bind_int(stmt.get(), 1, bookingId);
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        throw runtime_error("Ошибка выполнения запроса для удаления брони: " + string(sqlite3_errmsg(db)));
     }
-    sqlite3_finalize(stmt);
+    return sqlite3_changes(db) > 0;
 }
 
-void BookingManager::updateBooking(int bookingId, const Booking& b) {
-    const char* sql = "UPDATE Bookings SET workstationId = ?, clientName = ?, bookingDate = ?, startHour = ?, startMinute = ?, endHour = ?, endMinute = ? WHERE bookingId = ?;";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-         string errMsgStr = sqlite3_errmsg(db);
-         sqlite3_finalize(stmt);
-         throw runtime_error("Ошибка подготовки запроса для обновления брони: " + errMsgStr);
-    }
-    sqlite3_bind_int(stmt, 1, b.getWorkstationId());
-    sqlite3_bind_text(stmt, 2, b.getClientName().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, b.getBookingDate().c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 4, b.getStartTime().hour);
-    sqlite3_bind_int(stmt, 5, b.getStartTime().minute);
-    sqlite3_bind_int(stmt, 6, b.getEndTime().hour);
-    sqlite3_bind_int(stmt, 7, b.getEndTime().minute);
-    sqlite3_bind_int(stmt, 8, bookingId);
-
-     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        string errMsgStr = sqlite3_errmsg(db);
-        sqlite3_finalize(stmt);
-        throw runtime_error("Ошибка выполнения запроса для обновления брони: " + errMsgStr);
+bool BookingManager::updateBooking(int bookingId, const Booking& b) {
+    if (!b.hasValidDate()) {
+        throw runtime_error("Некорректная дата бронирования для брони " + to_string(b.getBookingId()));
     }
-    sqlite3_finalize(stmt);
+    const char* sql = "UPDATE Bookings SET workstationId = ?, clientId = ?, bookingDay = ?, startMinute = ?, endMinute = ? WHERE bookingId = ?;";
+    CachedStatement stmt(*statements, sql);
+    if (!stmt) {
+        throw runtime_error("Ошибка подготовки запроса для обновления брони: " + string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_int(stmt.get(), 1, b.getWorkstationId());
+    sqlite3_bind_int(stmt.get(), 2, b.getClientId());
+    sqlite3_bind_int(stmt.get(), 3, b.getBookingDate().days());
+    sqlite3_bind_int(stmt.get(), 4, b.getStartTime().totalMinutes());
+    sqlite3_bind_int(stmt.get(), 5, b.getEndTime().totalMinutes());
+    sqlite3_bind_int(stmt.get(), 6, bookingId);
+
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        throw runtime_error("Ошибка выполнения запроса для обновления брони: " + string(sqlite3_errmsg(db)));
+    }
+    return sqlite3_changes(db) > 0;
+}
+
+PurgeResult BookingManager::purgeExpired(chrono::system_clock::time_point now) {
+    PurgeResult result;
+    LocalDateTime local = toLocalDateTime(now);
+
+    UnitOfWork work(*this);
+    const char* deleteSql = "DELETE FROM Bookings WHERE bookingDay <= ?1 AND (bookingDay < ?1 OR endMinute <= ?2) "
+                            "RETURNING bookingId, workstationId;";
+    CachedStatement deleteStmt(*statements, deleteSql);
+    if (!deleteStmt) {
+        throw runtime_error("Ошибка подготовки запроса для удаления просроченных броней: " + string(sqlite3_errmsg(db)));
+    }
+    sqlite3_bind_int(deleteStmt.get(), 1, local.date.days());
+    sqlite3_bind_int(deleteStmt.get(), 2, local.time.totalMinutes());
+    int rc;
+    while ((rc = sqlite3_step(deleteStmt.get())) == SQLITE_ROW) {
+        result.bookingIds.push_back(sqlite3_column_int(deleteStmt.get(), 0));
+        result.workstationIds.push_back(sqlite3_column_int(deleteStmt.get(), 1));
+    }
+    if (rc != SQLITE_DONE) {
+        throw runtime_error("Ошибка выполнения запроса для удаления просроченных броней: " + string(sqlite3_errmsg(db)));
+    }
+    releaseIdleWorkstations(result);
+    work.commit();
+    return result;
+}
+
+PurgeResult BookingManager::expireBookings(const vector<int>& bookingIds, chrono::system_clock::time_point now) {
+    PurgeResult result;
+    LocalDateTime local = toLocalDateTime(now);
+
+    UnitOfWork work(*this);
+    // Условие по времени повторяется: бронь могли продлить после постановки в очередь.
+    const char* deleteSql = "DELETE FROM Bookings WHERE bookingId = ?3 AND bookingDay <= ?1 AND (bookingDay < ?1 OR endMinute <= ?2) "
+                            "RETURNING workstationId;";
+    for (int bookingId : bookingIds) {
+        CachedStatement deleteStmt(*statements, deleteSql);
+        if (!deleteStmt) {
+            throw runtime_error("Ошибка подготовки запроса для удаления просроченной брони: " + string(sqlite3_errmsg(db)));
+        }
+        sqlite3_bind_int(deleteStmt.get(), 1, local.date.days());
+        sqlite3_bind_int(deleteStmt.get(), 2, local.time.totalMinutes());
+        sqlite3_bind_int(deleteStmt.get(), 3, bookingId);
+        int rc;
+        while ((rc = sqlite3_step(deleteStmt.get())) == SQLITE_ROW) {
+            result.bookingIds.push_back(bookingId);
+            result.workstationIds.push_back(sqlite3_column_int(deleteStmt.get(), 0));
+        }
+        if (rc != SQLITE_DONE) {
+            throw runtime_error("Ошибка выполнения запроса для удаления просроченной брони: " + string(sqlite3_errmsg(db)));
+        }
+    }
+    releaseIdleWorkstations(result);
+    work.commit();
+    return result;
+}
+
+void BookingManager::releaseIdleWorkstations(PurgeResult& result) {
+    sort(result.workstationIds.begin(), result.workstationIds.end());
+    result.workstationIds.erase(unique(result.workstationIds.begin(), result.workstationIds.end()), result.workstationIds.end());
+
+    // Все просроченные брони уже удалены, значит любая оставшаяся бронь станции — текущая или будущая.
+    const char* releaseSql = "UPDATE Workstations SET status = ?2 WHERE id = ?1 AND status = ?3 "
+                             "AND NOT EXISTS (SELECT 1 FROM Bookings WHERE workstationId = ?1);";
+    for (int wsId : result.workstationIds) {
+        CachedStatement releaseStmt(*statements, releaseSql);
+        if (!releaseStmt) {
+            throw runtime_error("Ошибка подготовки запроса для освобождения станции: " + string(sqlite3_errmsg(db)));
+        }
+        sqlite3_bind_int(releaseStmt.get(), 1, wsId);
+        sqlite3_bind_int(releaseStmt.get(), 2, static_cast<int>(WorkstationStatus::Available));
+        sqlite3_bind_int(releaseStmt.get(), 3, static_cast<int>(WorkstationStatus::Booked));
+        if (sqlite3_step(releaseStmt.get()) != SQLITE_DONE) {
+            throw runtime_error("Ошибка выполнения запроса для освобождения станции: " + string(sqlite3_errmsg(db)));
+        }
+        if (sqlite3_changes(db) > 0) {
+            result.releasedWorkstationIds.push_back(wsId);
+        }
+    }
+}
+
+int BookingManager::rowId(const AnyWorkstation& ws) {
+    return workstationId(ws);
+}
+
+int BookingManager::rowId(const Booking& b) {
+    return b.getBookingId();
+}
+
+void BookingManager::recordBulkRow(BulkInsertReport& report, size_t index, int id, bool inserted, string& error) {
+    if (inserted) {
+        ++report.inserted;
+        return;
+    }
+    // Ошибка ограничения откатывает только текущую строку; если же SQLite
+    // откатил всю транзакцию (диск полон, ошибка ввода-вывода), продолжать нельзя.
+    if (sqlite3_get_autocommit(db)) {
+        throw runtime_error("Пакетная вставка прервана на строке " + to_string(index) + ": " + error);
+    }
+    report.rejected.push_back({ index, id, move(error) });
+    error.clear();
+}
+
+BulkInsertReport BookingManager::addWorkstations(const vector<AnyWorkstation>& workstations) {
+    return addWorkstations(workstations.begin(), workstations.end());
+}
+
+BulkInsertReport BookingManager::addBookings(const vector<Booking>& bookings) {
+    return addBookings(bookings.begin(), bookings.end());
 }
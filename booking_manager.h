@@ -3,30 +3,179 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <chrono>
+#include "statement_cache.h"
+#include "booking_cursor.h"
+#include "storage_config.h"
+#include "workstation.h"
+#include "client_directory.h"
 
-class Workstation;
 class Booking;
 struct sqlite3;
 
+struct RejectedRow {
+    std::size_t index;
+    int id;
+    std::string error;
+};
+
+struct PurgeResult {
+    std::vector<int> bookingIds;
+    std::vector<int> workstationIds;         // станции удалённых бронирований (без повторов)
+    std::vector<int> releasedWorkstationIds; // из них переведены в available
+};
+
+struct BulkInsertReport {
+    std::size_t inserted = 0;
+    std::vector<RejectedRow> rejected;
+};
+
 class BookingManager {
+public:
+    static constexpr int kSchemaVersion = 5;
+
 private:
     sqlite3* db;
+    StorageConfig config;
+    std::unique_ptr<StatementCache> statements;
+    int transactionDepth = 0;
+    ClientDirectory clients;
+    // Клиенты, добавленные внутри транзакции, и глубина, на которой это
+    // произошло: при откате этой точки сохранения их нужно забыть.
+    std::vector<std::pair<int, int>> pendingClients;
+    void settlePendingClients(bool rolledBack) noexcept;
+    void applyStorageConfig();
     void initializeDatabase();
+    int readSchemaVersion();
+    bool queryHasRow(const char* sql, const std::string& context);
+    bool hasLegacyBookingsTable();
+    void migrateBookingsToV2();
+    bool hasLegacyWorkstationsTable();
+    void migrateWorkstationsToV3();
+    void migrateWorkstationsToV4();
+    bool hasClientNameColumn();
+    void migrateBookingsToV5();
+    void loadClients();
+    void execSql(const char* sql, const std::string& context);
+
+    // Вложенные вызовы превращаются в SAVEPOINT внутри внешней транзакции.
+    void beginTransaction();
+    void commitTransaction();
+    void rollbackTransaction() noexcept;
+    friend class UnitOfWork;
+
+    bool insertRow(const AnyWorkstation& ws, std::string& error);
+    bool insertRow(const Booking& b, std::string& error);
+    static int rowId(const AnyWorkstation& ws);
+    static int rowId(const Booking& b);
+    // Освобождает станции из result.workstationIds, у которых не осталось броней.
+    void releaseIdleWorkstations(PurgeResult& result);
+    void recordBulkRow(BulkInsertReport& report, std::size_t index, int id, bool inserted, std::string& error);
+
+    template <typename It>
+    BulkInsertReport insertRange(It first, It last);
 
 public:
-    BookingManager();
+    explicit BookingManager(const StorageConfig& _config = StorageConfig::durableFast());
     ~BookingManager();
     BookingManager(const BookingManager&) = delete;
     BookingManager& operator=(const BookingManager&) = delete;
 
-    std::vector<Workstation> loadWorkstations();
+    const StorageConfig& getStorageConfig() const { return config; }
+    StatementCacheStats getStatementCacheStats() const;
+    int getTransactionDepth() const { return transactionDepth; }
+    // false вне транзакции, в том числе после того, как SQLite откатил её сам.
+    bool inTransaction() const;
+
+    // Клиенты загружаются при открытии базы; поиск по имени — хеш-таблица.
+    const ClientDirectory& getClients() const { return clients; }
+    // ID клиента по имени; нового клиента добавляет в таблицу Clients.
+    int clientIdFor(const std::string& name);
+
+    // Потоковое чтение без материализации таблицы: строка за строкой.
+    // Обход прекращается, как только visit вернёт false.
+    WorkstationCursor openWorkstations();
+    BookingCursor openBookings();
+    void forEachWorkstation(const std::function<bool(const WorkstationRow&)>& visit);
+    void forEachBooking(const std::function<bool(const BookingRow&)>& visit);
+
+    std::vector<AnyWorkstation> loadWorkstations();
     std::vector<Booking> loadBookings();
-    void addWorkstation(const Workstation& ws);
+
+    // Выборки по индексам; day — номер дня от 01-01-1970 (см. civil_date.h).
+    std::vector<Booking> loadBookingsForDay(Date day);
+    std::vector<Booking> loadBookingsForWorkstation(int workstationId, Date fromDay, Date toDay);
+    std::vector<Booking> loadActiveBookings(std::chrono::system_clock::time_point now);
+    void addWorkstation(const AnyWorkstation& ws);
     void deleteWorkstation(int id);
-    void updateWorkstationStatus(int id, const std::string& newStatus);
+    void updateWorkstationStatus(int id, WorkstationStatus newStatus);
     void addBooking(const Booking& b);
-    void deleteBooking(int bookingId);
-    void updateBooking(int bookingId, const Booking& b);
+    // false, если брони с таким ID в базе нет (например, её уже удалил ExpiryScheduler).
+    bool deleteBooking(int bookingId);
+    bool updateBooking(int bookingId, const Booking& b);
+
+    // Удаляет все бронирования, закончившиеся к моменту now, и освобождает
+    // станции, у которых не осталось броней, — одной транзакцией.
+    PurgeResult purgeExpired(std::chrono::system_clock::time_point now);
+    // То же для выбранных броней (см. ExpiryScheduler): удаляются только
+    // те из них, что действительно закончились к now.
+    PurgeResult expireBookings(const std::vector<int>& bookingIds, std::chrono::system_clock::time_point now);
+
+    // Пакетная вставка в одной транзакции. Строки, нарушившие ограничения,
+    // не прерывают загрузку, а попадают в BulkInsertReport::rejected.
+    template <typename It>
+    BulkInsertReport addWorkstations(It first, It last);
+    template <typename It>
+    BulkInsertReport addBookings(It first, It last);
+    BulkInsertReport addWorkstations(const std::vector<AnyWorkstation>& workstations);
+    BulkInsertReport addBookings(const std::vector<Booking>& bookings);
 };
 
+// Единица работы: все изменения станций и бронирований между созданием
+// объекта и commit() фиксируются одной транзакцией. Если commit() не был
+// вызван (например, вылетело исключение), изменения откатываются.
+// Вложенные UnitOfWork реализованы точками сохранения (SAVEPOINT).
+class UnitOfWork {
+private:
+    BookingManager& manager;
+    bool active;
+
+public:
+    explicit UnitOfWork(BookingManager& _manager);
+    ~UnitOfWork();
+    UnitOfWork(const UnitOfWork&) = delete;
+    UnitOfWork& operator=(const UnitOfWork&) = delete;
+
+    void commit();
+    void rollback() noexcept;
+};
+
+template <typename It>
+BulkInsertReport BookingManager::insertRange(It first, It last) {
+    BulkInsertReport report;
+    std::string error;
+    UnitOfWork work(*this);
+    std::size_t index = 0;
+    for (; first != last; ++first, ++index) {
+        bool inserted = insertRow(*first, error);
+        recordBulkRow(report, index, rowId(*first), inserted, error);
+    }
+    work.commit();
+    return report;
+}
+
+template <typename It>
+BulkInsertReport BookingManager::addWorkstations(It first, It last) {
+    return insertRange(first, last);
+}
+
+template <typename It>
+BulkInsertReport BookingManager::addBookings(It first, It last) {
+    return insertRange(first, last);
+}
+
 #endif // BOOKING_MANAGER_H
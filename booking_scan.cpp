@@ -0,0 +1,110 @@
+#include "booking_scan.h"
+#include <algorithm>
+#include "civil_date.h"
+#if defined(KPK_HAS_AVX2)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+// Скалярные ядра пишут номер строки всегда, а сдвигают счётчик только при
+// совпадении: в цикле нет ветвлений, которые предсказатель угадывает плохо.
+constexpr size_t kScanBlock = 256;
+
+template <typename Match>
+static void scanRows(size_t first, size_t n, Match match, vector<uint32_t>& rows) {
+    uint32_t block[kScanBlock];
+    for (size_t start = first; start < n; start += kScanBlock) {
+        size_t stop = min(n, start + kScanBlock);
+        size_t count = 0;
+        for (size_t i = start; i < stop; ++i) {
+            block[count] = static_cast<uint32_t>(i);
+            count += match(i) ? 1 : 0;
+        }
+        rows.insert(rows.end(), block, block + count);
+    }
+}
+
+static bool hasEnded(int32_t day, uint16_t endMinute, int32_t nowDay, int nowMinute) {
+    return day != Date::kInvalidDay && (day < nowDay || (day == nowDay && endMinute <= nowMinute));
+}
+
+void matchEqualScalar(const int32_t* column, size_t n, int32_t value, vector<uint32_t>& rows) {
+    scanRows(0, n, [&](size_t i) { return column[i] == value; }, rows);
+}
+
+void matchEndedScalar(const int32_t* days, const uint16_t* endMinutes, size_t n,
+                      int32_t nowDay, int nowMinute, vector<uint32_t>& rows) {
+    scanRows(0, n, [&](size_t i) { return hasEnded(days[i], endMinutes[i], nowDay, nowMinute); }, rows);
+}
+
+#if defined(KPK_HAS_AVX2)
+static int lowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static void appendMask(size_t base, unsigned mask, vector<uint32_t>& rows) {
+    while (mask) {
+        rows.push_back(static_cast<uint32_t>(base + lowestBit(mask)));
+        mask &= mask - 1;
+    }
+}
+
+static unsigned laneMask(__m256i lanes) {
+    return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(lanes)));
+}
+
+void matchEqualAvx2(const int32_t* column, size_t n, int32_t value, vector<uint32_t>& rows) {
+    const __m256i needle = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+        appendMask(i, laneMask(_mm256_cmpeq_epi32(v, needle)), rows);
+    }
+    scanRows(i, n, [&](size_t j) { return column[j] == value; }, rows);
+}
+
+void matchEndedAvx2(const int32_t* days, const uint16_t* endMinutes, size_t n,
+                    int32_t nowDay, int nowMinute, vector<uint32_t>& rows) {
+    const __m256i today = _mm256_set1_epi32(nowDay);
+    // end <= nowMinute  <=>  nowMinute + 1 > end
+    const __m256i minuteLimit = _mm256_set1_epi32(nowMinute + 1);
+    const __m256i invalid = _mm256_set1_epi32(Date::kInvalidDay);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i day = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(days + i));
+        __m256i end = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(endMinutes + i)));
+        __m256i before = _mm256_cmpgt_epi32(today, day);
+        __m256i endedToday = _mm256_and_si256(_mm256_cmpeq_epi32(day, today), _mm256_cmpgt_epi32(minuteLimit, end));
+        __m256i ended = _mm256_andnot_si256(_mm256_cmpeq_epi32(day, invalid), _mm256_or_si256(before, endedToday));
+        appendMask(i, laneMask(ended), rows);
+    }
+    scanRows(i, n, [&](size_t j) { return hasEnded(days[j], endMinutes[j], nowDay, nowMinute); }, rows);
+}
+#endif
+
+void matchEqual(const int32_t* column, size_t n, int32_t value, vector<uint32_t>& rows) {
+#if defined(KPK_HAS_AVX2)
+    matchEqualAvx2(column, n, value, rows);
+#else
+    matchEqualScalar(column, n, value, rows);
+#endif
+}
+
+void matchEnded(const int32_t* days, const uint16_t* endMinutes, size_t n,
+                int32_t nowDay, int nowMinute, vector<uint32_t>& rows) {
+#if defined(KPK_HAS_AVX2)
+    matchEndedAvx2(days, endMinutes, n, nowDay, nowMinute, rows);
+#else
+    matchEndedScalar(days, endMinutes, n, nowDay, nowMinute, rows);
+#endif
+}
@@ -0,0 +1,30 @@
+#ifndef BOOKING_SCAN_H
+#define BOOKING_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Ядра выборок по столбцам броней (см. booking_store.h). Каждое ядро
+// дописывает в rows номера подходящих строк по возрастанию.
+
+// Строки, где column[i] == value (фильтр по станции или по дню).
+void matchEqualScalar(const std::int32_t* column, std::size_t n, std::int32_t value, std::vector<std::uint32_t>& rows);
+
+// Строки с корректной датой, закончившиеся не позже (nowDay, nowMinute).
+void matchEndedScalar(const std::int32_t* days, const std::uint16_t* endMinutes, std::size_t n,
+                      std::int32_t nowDay, int nowMinute, std::vector<std::uint32_t>& rows);
+
+#if defined(__AVX2__)
+#define KPK_HAS_AVX2 1
+void matchEqualAvx2(const std::int32_t* column, std::size_t n, std::int32_t value, std::vector<std::uint32_t>& rows);
+void matchEndedAvx2(const std::int32_t* days, const std::uint16_t* endMinutes, std::size_t n,
+                    std::int32_t nowDay, int nowMinute, std::vector<std::uint32_t>& rows);
+#endif
+
+// Выбирают AVX2-ядро, если программа собрана с поддержкой AVX2 (KPK_ENABLE_AVX2).
+void matchEqual(const std::int32_t* column, std::size_t n, std::int32_t value, std::vector<std::uint32_t>& rows);
+void matchEnded(const std::int32_t* days, const std::uint16_t* endMinutes, std::size_t n,
+                std::int32_t nowDay, int nowMinute, std::vector<std::uint32_t>& rows);
+
+#endif // BOOKING_SCAN_H
@@ -0,0 +1,513 @@
+#include "booking_server.h"
+#include "booking_engine.h"
+#include "json_line.h"
+#include "sharded_engine.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+// Сколько байт читать из одного соединения за пробуждение: один клиент
+// с потоком запросов не должен задерживать остальных.
+static constexpr size_t kReadBudget = 256 * 1024;
+
+struct BookingServer::Connection {
+    int fd;
+    string input;           // прочитано, но ещё не выполнено
+    string output;          // ответы, ещё не отправленные целиком
+    size_t outputSent = 0;
+    size_t requests = 0;    // номер последнего запроса — поле "line" ответа
+    uint32_t events = 0;    // текущая подписка epoll
+    bool peerClosed = false; // клиент закрыл свою сторону
+    bool closing = false;    // закрыть, как только ответы уйдут
+
+    explicit Connection(int _fd) : fd(_fd) {}
+    size_t pendingOutput() const { return output.size() - outputSent; }
+};
+
+static runtime_error socketError(const string& context) {
+    return runtime_error(context + ": " + strerror(errno));
+}
+
+static bool isBlank(string_view line) {
+    return line.find_first_not_of(" \t\r") == string_view::npos;
+}
+
+BookingServer::BookingServer(BookingEngine& _engine, const ServerConfig& _config)
+    : engine(&_engine), config(_config) {
+    open();
+}
+
+BookingServer::BookingServer(ShardedEngine& _engine, const ServerConfig& _config)
+    : shardedEngine(&_engine), config(_config) {
+    open();
+}
+
+void BookingServer::open() {
+    try {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) {
+            throw socketError("Не удалось создать epoll");
+        }
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0) {
+            throw socketError("Не удалось создать eventfd");
+        }
+        watch(wakeFd, EPOLLIN);
+
+        if (config.listenTcp) {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(config.tcpPort);
+            if (inet_pton(AF_INET, config.tcpHost.c_str(), &addr.sin_addr) != 1) {
+                throw runtime_error("Неверный адрес IPv4: " + config.tcpHost);
+            }
+            tcpFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (tcpFd < 0) {
+                throw socketError("Не удалось создать TCP-сокет");
+            }
+            int on = 1;
+            setsockopt(tcpFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (bind(tcpFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+                throw socketError("Не удалось занять порт " + config.tcpHost + ":" + to_string(config.tcpPort));
+            }
+            if (listen(tcpFd, SOMAXCONN) < 0) {
+                throw socketError("Не удалось слушать TCP-порт");
+            }
+            socklen_t len = sizeof(addr);
+            getsockname(tcpFd, reinterpret_cast<sockaddr*>(&addr), &len);
+            boundTcpPort = ntohs(addr.sin_port);
+            watch(tcpFd, EPOLLIN);
+        }
+
+        if (!config.unixPath.empty()) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            if (config.unixPath.size() >= sizeof(addr.sun_path)) {
+                throw runtime_error("Слишком длинный путь Unix-сокета: " + config.unixPath);
+            }
+            memcpy(addr.sun_path, config.unixPath.c_str(), config.unixPath.size() + 1);
+            unixFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (unixFd < 0) {
+                throw socketError("Не удалось создать Unix-сокет");
+            }
+            // Файл сокета от прошлого запуска мешает bind.
+            unlink(config.unixPath.c_str());
+            if (bind(unixFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+                throw socketError("Не удалось создать сокет " + config.unixPath);
+            }
+            if (listen(unixFd, SOMAXCONN) < 0) {
+                throw socketError("Не удалось слушать Unix-сокет");
+            }
+            watch(unixFd, EPOLLIN);
+        }
+    } catch (...) {
+        closeAll();
+        throw;
+    }
+}
+
+BookingServer::~BookingServer() {
+    closeAll();
+}
+
+void BookingServer::closeAll() {
+    for (auto& entry : connections) {
+        ::close(entry.first);
+    }
+    connections.clear();
+    if (unixFd >= 0) {
+        ::close(unixFd);
+        unlink(config.unixPath.c_str());
+        unixFd = -1;
+    }
+    for (int* fd : { &tcpFd, &wakeFd, &epollFd }) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void BookingServer::watch(int fd, uint32_t events) {
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        throw socketError("Не удалось добавить сокет в epoll");
+    }
+}
+
+void BookingServer::stop() {
+    uint64_t one = 1;
+    ssize_t written = ::write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+void BookingServer::accept(int listenFd) {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            // EAGAIN — очередь пуста; EMFILE и подобные — клиент подождёт
+            // в очереди listen до следующего пробуждения.
+            return;
+        }
+        if (listenFd == tcpFd) {
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+        auto conn = make_unique<Connection>(fd);
+        conn->events = EPOLLIN;
+        try {
+            watch(fd, conn->events);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        connections.emplace(fd, move(conn));
+    }
+}
+
+bool BookingServer::readFrom(Connection& conn) {
+    char buffer[16 * 1024];
+    size_t budget = kReadBudget;
+    while (budget > 0 && !conn.peerClosed && conn.pendingOutput() < config.maxPendingOutput) {
+        ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.input.append(buffer, static_cast<size_t>(n));
+            budget -= min(budget, static_cast<size_t>(n));
+        } else if (n == 0) {
+            conn.peerClosed = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+    return true;
+}
+
+bool BookingServer::hasRequest(const Connection& conn) const {
+    if (conn.closing || conn.input.empty() || conn.pendingOutput() >= config.maxPendingOutput) {
+        return false;
+    }
+    // После EOF последняя строка выполняется и без перевода строки.
+    return conn.peerClosed || conn.input.size() > config.maxRequestBytes ||
+           memchr(conn.input.data(), '\n', conn.input.size()) != nullptr;
+}
+
+bool BookingServer::nextRequest(const Connection& conn, size_t& pos, string_view& line) const {
+    string_view input(conn.input);
+    while (pos < input.size() && conn.pendingOutput() < config.maxPendingOutput) {
+        size_t newline = input.find('\n', pos);
+        if (newline == string_view::npos && !conn.peerClosed) {
+            return false;
+        }
+        size_t end = newline == string_view::npos ? input.size() : newline;
+        if (end - pos > config.maxRequestBytes) {
+            return false;
+        }
+        line = input.substr(pos, end - pos);
+        pos = end == input.size() ? end : end + 1;
+        if (!isBlank(line)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BookingServer::executeLines(Connection& conn, const string* failure) {
+    size_t pos = 0;
+    string_view line;
+    while (nextRequest(conn, pos, line)) {
+        if (failure) {
+            appendFailure(conn, ++conn.requests, *failure);
+        } else {
+            executeCommandLine(*engine, line, ++conn.requests, conn.output, summary);
+        }
+    }
+    finishInput(conn, pos);
+}
+
+void BookingServer::finishInput(Connection& conn, size_t pos) {
+    conn.input.erase(0, pos);
+
+    // Строка без конца длиннее предела: ответить и разорвать соединение,
+    // иначе клиент может занять сколько угодно памяти.
+    size_t newline = conn.input.find('\n');
+    if ((newline == string::npos ? conn.input.size() : newline) > config.maxRequestBytes) {
+        ++summary.commands;
+        ++summary.invalid;
+        conn.output += "{\"line\":" + to_string(++conn.requests) + ",\"status\":\"invalid\",\"message\":";
+        appendJsonString(conn.output, "запрос длиннее " + to_string(config.maxRequestBytes) + " байт");
+        conn.output += "}\n";
+        conn.input.clear();
+        conn.closing = true;
+    }
+}
+
+void BookingServer::appendFailure(Connection& conn, size_t line, const string& message) {
+    ++summary.commands;
+    ++summary.failed;
+    conn.output += "{\"line\":" + to_string(line) + ",\"status\":\"error\",\"message\":";
+    appendJsonString(conn.output, message);
+    conn.output += "}\n";
+}
+
+// Ошибка базы — транзакция пробуждения не открылась или не зафиксировалась
+// (например, соединение истечения держало блокировку записи дольше
+// busyTimeoutMs) — не останавливает сервер. Ответы на запросы пробуждения
+// заменяются ошибкой, движок загружается из базы заново, следующее
+// пробуждение снова открывает транзакцию.
+void BookingServer::executeBatch(const vector<Connection*>& pending) {
+    struct Mark {
+        size_t output;
+        size_t requests;
+    };
+    vector<Mark> marks;
+    marks.reserve(pending.size());
+    BatchSummary before = summary;
+    string failure;
+    try {
+        if (engineStale) {
+            engine->reload();
+            engineStale = false;
+        }
+        // С writeBehind пишет очередь движка: ответы уходят после flushWrites().
+        optional<UnitOfWork> work;
+        if (!engine->writesBehind()) {
+            work.emplace(engine->getManager());
+        }
+        for (Connection* conn : pending) {
+            marks.push_back({ conn->output.size(), conn->requests });
+            executeLines(*conn);
+        }
+        if (work) {
+            work->commit();
+        } else {
+            engine->flushWrites();
+        }
+        ++summary.commits;
+        return;
+    } catch (const exception& e) {
+        failure = string("Не удалось зафиксировать запросы: ") + e.what();
+    }
+
+    // Выполненные запросы откатились вместе с транзакцией: их ответы
+    // заменяются ошибкой; до остальных соединений очередь не дошла.
+    summary = before;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        Connection& conn = *pending[i];
+        if (i < marks.size()) {
+            conn.output.resize(marks[i].output);
+            for (size_t line = marks[i].requests + 1; line <= conn.requests; ++line) {
+                appendFailure(conn, line, failure);
+            }
+        } else {
+            executeLines(conn, &failure);
+        }
+    }
+    if (!marks.empty() || engine->writesBehind()) {
+        engineStale = true;
+    }
+    if (engineStale) {
+        try {
+            engine->reload();
+            engineStale = false;
+        } catch (const exception&) {
+            // Повторится в следующем пробуждении.
+        }
+    }
+}
+
+// Раунд — по одному запросу от каждого соединения: изменения раунда
+// одновременно стоят в очередях своих разделов и фиксируются их пачками.
+// Следующий запрос соединения начинается после ответа на предыдущий и
+// видит его результат. Ошибки базы приходят в ответах отдельных запросов:
+// раздел сам перезагружает движок после неудачного COMMIT.
+void BookingServer::executeSharded(const vector<Connection*>& pending) {
+    vector<size_t> positions(pending.size(), 0);
+    vector<pair<Connection*, PendingReply>> round;
+    round.reserve(pending.size());
+    for (;;) {
+        round.clear();
+        for (size_t i = 0; i < pending.size(); ++i) {
+            Connection& conn = *pending[i];
+            string_view line;
+            if (nextRequest(conn, positions[i], line)) {
+                round.emplace_back(&conn, startCommandLine(*shardedEngine, line, ++conn.requests));
+            }
+        }
+        if (round.empty()) {
+            break;
+        }
+        for (auto& [conn, reply] : round) {
+            reply(conn->output, summary);
+        }
+    }
+    for (size_t i = 0; i < pending.size(); ++i) {
+        finishInput(*pending[i], positions[i]);
+    }
+}
+
+bool BookingServer::flush(Connection& conn) {
+    while (conn.outputSent < conn.output.size()) {
+        ssize_t n = send(conn.fd, conn.output.data() + conn.outputSent, conn.output.size() - conn.outputSent,
+                         MSG_NOSIGNAL);
+        if (n >= 0) {
+            conn.outputSent += static_cast<size_t>(n);
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            close(conn);
+            return false;
+        }
+    }
+    if (conn.outputSent == conn.output.size()) {
+        conn.output.clear();
+        conn.outputSent = 0;
+        if (conn.closing || (conn.peerClosed && conn.input.empty())) {
+            close(conn);
+            return false;
+        }
+    } else if (conn.outputSent >= kReadBudget) {
+        conn.output.erase(0, conn.outputSent);
+        conn.outputSent = 0;
+    }
+    updateInterest(conn);
+    return true;
+}
+
+void BookingServer::updateInterest(Connection& conn) {
+    uint32_t events = 0;
+    if (!conn.peerClosed && !conn.closing && conn.pendingOutput() < config.maxPendingOutput) {
+        events |= EPOLLIN;
+    }
+    if (conn.pendingOutput() > 0) {
+        events |= EPOLLOUT;
+    }
+    if (events == conn.events) {
+        return;
+    }
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = conn.fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev) < 0) {
+        throw socketError("Не удалось изменить подписку epoll");
+    }
+    conn.events = events;
+}
+
+void BookingServer::close(Connection& conn) {
+    int fd = conn.fd;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+void BookingServer::run() {
+    vector<epoll_event> events(static_cast<size_t>(config.maxEvents > 0 ? config.maxEvents : 1));
+    vector<int> ready;
+    vector<Connection*> pending;
+    // Соединения, у которых после прошлого прохода остались целые строки
+    // запросов: выполнение остановилось на пределе maxPendingOutput, и новых
+    // событий epoll для них может не быть (всё уже прочитано или клиент
+    // закрыл свою сторону). Пока они есть, epoll_wait не ждёт.
+    vector<int> backlog;
+    bool stopping = false;
+    while (!stopping) {
+        int timeout = backlog.empty() ? config.expiryPollMs : 0;
+        int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeout);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw socketError("Ошибка epoll_wait");
+        }
+
+        ready.clear();
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                uint64_t value;
+                ssize_t drained = ::read(wakeFd, &value, sizeof(value));
+                (void)drained;
+                stopping = true;
+                continue;
+            }
+            if (fd == tcpFd || fd == unixFd) {
+                accept(fd);
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end()) {
+                continue;
+            }
+            Connection& conn = *it->second;
+            if (events[i].events & EPOLLERR) {
+                close(conn);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && !flush(conn)) {
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLHUP)) && !readFrom(conn)) {
+                close(conn);
+                continue;
+            }
+            ready.push_back(fd);
+        }
+        for (int fd : backlog) {
+            if (find(ready.begin(), ready.end(), fd) == ready.end()) {
+                ready.push_back(fd);
+            }
+        }
+
+        // Брони, истёкшие в фоновом потоке, применяются до новых запросов
+        // (разделы ShardedEngine забирают их сами).
+        if (engine) {
+            engine->collectExpired();
+        }
+
+        pending.clear();
+        for (int fd : ready) {
+            auto it = connections.find(fd);
+            if (it != connections.end() && hasRequest(*it->second)) {
+                pending.push_back(it->second.get());
+            }
+        }
+        if (!pending.empty()) {
+            if (shardedEngine) {
+                executeSharded(pending);
+            } else {
+                executeBatch(pending);
+            }
+        }
+
+        backlog.clear();
+        for (int fd : ready) {
+            auto it = connections.find(fd);
+            if (it != connections.end() && flush(*it->second) && hasRequest(*it->second)) {
+                backlog.push_back(fd);
+            }
+        }
+    }
+}
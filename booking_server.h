@@ -0,0 +1,104 @@
+#ifndef BOOKING_SERVER_H
+#define BOOKING_SERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "batch_runner.h"
+
+class BookingEngine;
+class ShardedEngine;
+
+struct ServerConfig {
+    // TCP: port 0 — любой свободный порт (см. BookingServer::tcpPort).
+    bool listenTcp = true;
+    std::string tcpHost = "127.0.0.1";
+    std::uint16_t tcpPort = 7878;
+    // Unix-сокет; пустой путь — не слушать.
+    std::string unixPath;
+    // Самая длинная строка запроса; длиннее — ответ invalid и закрытие соединения.
+    std::size_t maxRequestBytes = 64 * 1024;
+    // Пока у клиента столько неотправленных байт ответов, его запросы не читаются.
+    std::size_t maxPendingOutput = 1024 * 1024;
+    int maxEvents = 256;
+    // Как часто забирать брони, истёкшие в фоновом потоке движка.
+    int expiryPollMs = 1000;
+};
+
+// Сервер бронирования (только Linux): один процесс владеет BookingEngine и
+// обслуживает клиентов по TCP и Unix-сокету в неблокирующем цикле epoll.
+// Протокол — те же строки JSONL, что и в пакетном режиме (batch_runner.h):
+// запрос — строка с командой, ответ — строка с результатом, поле "line" —
+// номер запроса в соединении. Клиент может слать запросы, не дожидаясь
+// ответов; ответы приходят в порядке запросов. Все запросы, прочитанные за
+// одно пробуждение цикла, выполняются в одной транзакции, ответы уходят
+// после её COMMIT. Если транзакцию не удалось открыть или зафиксировать,
+// запросы этого пробуждения получают ответ error, движок загружается из
+// базы заново, и сервер продолжает работу.
+//
+// С ShardedEngine общей транзакции нет: запросы идут раундами, по одному
+// от каждого соединения, изменения раунда одновременно стоят в очередях
+// разделов, и ответ приходит после COMMIT пачки своего раздела.
+class BookingServer {
+private:
+    struct Connection;
+
+    // Ровно один из двух движков.
+    BookingEngine* engine = nullptr;
+    ShardedEngine* shardedEngine = nullptr;
+    ServerConfig config;
+    int epollFd = -1;
+    int wakeFd = -1;
+    int tcpFd = -1;
+    int unixFd = -1;
+    std::uint16_t boundTcpPort = 0;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    BatchSummary summary;
+    bool engineStale = false; // память движка не совпадает с базой, нужен reload()
+
+    void open();
+    void watch(int fd, std::uint32_t events);
+    void closeAll();
+    void accept(int listenFd);
+    // false — ошибка сокета, соединение нужно закрыть.
+    bool readFrom(Connection& conn);
+    bool hasRequest(const Connection& conn) const;
+    // Следующая непустая строка запроса с позиции pos; false — целых строк
+    // больше нет или ответы упёрлись в maxPendingOutput.
+    bool nextRequest(const Connection& conn, std::size_t& pos, std::string_view& line) const;
+    // Убирает выполненные строки (до pos) из входного буфера.
+    void finishInput(Connection& conn, std::size_t pos);
+    // С failure строки не выполняются: каждая получает ответ error.
+    void executeLines(Connection& conn, const std::string* failure = nullptr);
+    void appendFailure(Connection& conn, std::size_t line, const std::string& message);
+    void executeBatch(const std::vector<Connection*>& pending);
+    void executeSharded(const std::vector<Connection*>& pending);
+    // false — соединение закрыто.
+    bool flush(Connection& conn);
+    void updateInterest(Connection& conn);
+    void close(Connection& conn);
+
+public:
+    BookingServer(BookingEngine& engine, const ServerConfig& config = ServerConfig());
+    BookingServer(ShardedEngine& engine, const ServerConfig& config = ServerConfig());
+    ~BookingServer();
+    BookingServer(const BookingServer&) = delete;
+    BookingServer& operator=(const BookingServer&) = delete;
+
+    // Фактический TCP-порт после привязки (0, если TCP выключен).
+    std::uint16_t tcpPort() const { return boundTcpPort; }
+
+    // Цикл обработки до вызова stop().
+    void run();
+    // Можно вызывать из другого потока и из обработчика сигнала.
+    void stop();
+
+    std::size_t connectionCount() const { return connections.size(); }
+    const BatchSummary& getSummary() const { return summary; }
+};
+
+#endif // BOOKING_SERVER_H
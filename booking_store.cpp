@@ -0,0 +1,153 @@
+#include "booking_store.h"
+#include "booking_scan.h"
+
+using namespace std;
+
+void BookingStore::writeRow(size_t row, const Booking& b) {
+    bookingIds[row] = b.getBookingId();
+    workstationIds[row] = b.getWorkstationId();
+    days[row] = b.getBookingDate().days();
+    startMinutes[row] = b.getStartTime().totalMinutes();
+    endMinutes[row] = b.getEndTime().totalMinutes();
+    clientIds[row] = b.getClientId();
+}
+
+vector<int> BookingStore::idsAt(const vector<uint32_t>& matchedRows) const {
+    vector<int> result;
+    result.reserve(matchedRows.size());
+    for (uint32_t row : matchedRows) {
+        result.push_back(bookingIds[row]);
+    }
+    return result;
+}
+
+optional<Booking> BookingStore::find(int id) const {
+    uint32_t row;
+    if (!rows.find(id, row)) {
+        return nullopt;
+    }
+    return rowAt(row);
+}
+
+Booking BookingStore::rowAt(size_t row) const {
+    return Booking(bookingIds[row], workstationIds[row], clientIds[row], Date(days[row]),
+                   TimeOfDay(startMinutes[row]), TimeOfDay(endMinutes[row]));
+}
+
+bool BookingStore::add(const Booking& b) {
+    uint32_t row = static_cast<uint32_t>(bookingIds.size());
+    if (!rows.insert(b.getBookingId(), row)) {
+        return false;
+    }
+    bookingIds.emplace_back();
+    workstationIds.emplace_back();
+    days.emplace_back();
+    startMinutes.emplace_back();
+    endMinutes.emplace_back();
+    clientIds.emplace_back();
+    writeRow(row, b);
+    return true;
+}
+
+bool BookingStore::erase(int id) {
+    uint32_t row;
+    if (!rows.find(id, row)) {
+        return false;
+    }
+    rows.erase(id);
+    size_t last = bookingIds.size() - 1;
+    if (row != last) {
+        bookingIds[row] = bookingIds[last];
+        workstationIds[row] = workstationIds[last];
+        days[row] = days[last];
+        startMinutes[row] = startMinutes[last];
+        endMinutes[row] = endMinutes[last];
+        clientIds[row] = clientIds[last];
+        rows.erase(bookingIds[row]);
+        rows.insert(bookingIds[row], row);
+    }
+    bookingIds.pop_back();
+    workstationIds.pop_back();
+    days.pop_back();
+    startMinutes.pop_back();
+    endMinutes.pop_back();
+    clientIds.pop_back();
+    return true;
+}
+
+bool BookingStore::replace(const Booking& b) {
+    uint32_t row;
+    if (!rows.find(b.getBookingId(), row)) {
+        return false;
+    }
+    writeRow(row, b);
+    return true;
+}
+
+void BookingStore::reserve(size_t expected) {
+    bookingIds.reserve(expected);
+    workstationIds.reserve(expected);
+    days.reserve(expected);
+    startMinutes.reserve(expected);
+    endMinutes.reserve(expected);
+    clientIds.reserve(expected);
+    rows.reserve(expected);
+}
+
+void BookingStore::clear() {
+    bookingIds.clear();
+    workstationIds.clear();
+    days.clear();
+    startMinutes.clear();
+    endMinutes.clear();
+    clientIds.clear();
+    rows.clear();
+}
+
+vector<int> BookingStore::idsForWorkstation(int workstationId) const {
+    vector<uint32_t> matched;
+    matchEqual(workstationIds.data(), workstationIds.size(), workstationId, matched);
+    return idsAt(matched);
+}
+
+vector<int> BookingStore::idsForDay(Date day) const {
+    vector<uint32_t> matched;
+    if (day.isValid()) {
+        matchEqual(days.data(), days.size(), day.days(), matched);
+    }
+    return idsAt(matched);
+}
+
+static void splitInstant(long long instant, int32_t& day, int& minute) {
+    long long wholeDays = instant / 1440;
+    long long rest = instant % 1440;
+    if (rest < 0) {
+        --wholeDays;
+        rest += 1440;
+    }
+    day = static_cast<int32_t>(wholeDays);
+    minute = static_cast<int>(rest);
+}
+
+vector<int> BookingStore::idsEndedBy(long long nowInstant) const {
+    int32_t nowDay;
+    int nowMinute;
+    splitInstant(nowInstant, nowDay, nowMinute);
+    vector<uint32_t> matched;
+    matchEnded(days.data(), endMinutes.data(), days.size(), nowDay, nowMinute, matched);
+    return idsAt(matched);
+}
+
+bool BookingStore::hasActiveOnWorkstation(int workstationId, long long nowInstant, int excludeBookingId) const {
+    vector<uint32_t> matched;
+    matchEqual(workstationIds.data(), workstationIds.size(), workstationId, matched);
+    for (uint32_t row : matched) {
+        if (bookingIds[row] == excludeBookingId || days[row] == Date::kInvalidDay) {
+            continue;
+        }
+        if (toLocalInstant(Date(days[row]), TimeOfDay(endMinutes[row])) > nowInstant) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,53 @@
+#ifndef BOOKING_STORE_H
+#define BOOKING_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "booking.h"
+#include "id_hash_index.h"
+
+// Брони по столбцам: ID, станция, день, начало, конец и номер клиента лежат
+// в отдельных плотных массивах, поэтому выборки по станции, дню или времени
+// окончания читают только нужные столбцы (см. booking_scan.h). Удаление
+// переносит последнюю строку на место удалённой, так что порядок строк не
+// сохраняется.
+class BookingStore {
+private:
+    std::vector<int> bookingIds;
+    std::vector<std::int32_t> workstationIds;
+    std::vector<std::int32_t> days;
+    std::vector<std::uint16_t> startMinutes;
+    std::vector<std::uint16_t> endMinutes;
+    std::vector<std::int32_t> clientIds;
+    IdHashIndex rows; // ID брони -> номер строки
+
+    void writeRow(std::size_t row, const Booking& b);
+    std::vector<int> idsAt(const std::vector<std::uint32_t>& matchedRows) const;
+
+public:
+    bool contains(int id) const { return rows.contains(id); }
+    // Бронь собирается из столбцов; пусто, если брони нет.
+    std::optional<Booking> find(int id) const;
+    Booking rowAt(std::size_t row) const;
+
+    // false, если бронь с таким ID уже есть.
+    bool add(const Booking& b);
+    bool erase(int id);
+    // Заменяет бронь с тем же ID; false, если её нет.
+    bool replace(const Booking& b);
+
+    void reserve(std::size_t expected);
+    void clear();
+    std::size_t size() const { return bookingIds.size(); }
+    bool empty() const { return bookingIds.empty(); }
+
+    std::vector<int> idsForWorkstation(int workstationId) const;
+    std::vector<int> idsForDay(Date day) const;
+    // Брони с корректной датой, закончившиеся не позже nowInstant (см. localInstantNow).
+    std::vector<int> idsEndedBy(long long nowInstant) const;
+    bool hasActiveOnWorkstation(int workstationId, long long nowInstant, int excludeBookingId = -1) const;
+};
+
+#endif // BOOKING_STORE_H
@@ -0,0 +1,126 @@
+#ifndef CIVIL_DATE_H
+#define CIVIL_DATE_H
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <ctime>
+#include <limits>
+#include "Time.h"
+
+// Календарная арифметика без mktime: номер дня отсчитывается от 01-01-1970
+// (пролептический григорианский календарь, алгоритмы Говарда Хиннанта).
+
+struct CivilDate {
+    int year;
+    int month; // 1..12
+    int day;   // 1..31
+};
+
+constexpr bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+constexpr int daysInMonth(int year, int month) {
+    constexpr int lengths[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return month == 2 && isLeapYear(year) ? 29 : lengths[month - 1];
+}
+
+constexpr bool isValidCivilDate(int year, int month, int day) {
+    return month >= 1 && month <= 12 && day >= 1 && day <= daysInMonth(year, month);
+}
+
+constexpr int daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = year - era * 400;
+    const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+constexpr CivilDate civilFromDays(int days) {
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const int dayOfEra = days - era * 146097;
+    const int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const int mp = (5 * dayOfYear + 2) / 153;
+    const int day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    const int month = mp < 10 ? mp + 3 : mp - 9;
+    return { yearOfEra + era * 400 + (month <= 2), month, day };
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "эпоха должна начинаться с 01-01-1970");
+static_assert(daysFromCivil(2000, 3, 1) == 11017, "ошибка в daysFromCivil");
+static_assert(civilFromDays(11017).month == 3, "ошибка в civilFromDays");
+
+// Разбор строки — в date_time_parser.h (parseDate).
+inline std::string dayToDate(int day) {
+    CivilDate civil = civilFromDays(day);
+    std::string result = "00-00-0000";
+    result[0] = static_cast<char>('0' + civil.day / 10);
+    result[1] = static_cast<char>('0' + civil.day % 10);
+    result[3] = static_cast<char>('0' + civil.month / 10);
+    result[4] = static_cast<char>('0' + civil.month % 10);
+    int year = civil.year;
+    for (int i = 9; i >= 6; --i, year /= 10) {
+        result[i] = static_cast<char>('0' + year % 10);
+    }
+    return result;
+}
+
+// Дата как номер дня от 01-01-1970; в строку DD-MM-YYYY переводится только при выводе.
+class Date {
+private:
+    std::int32_t dayNumber;
+
+public:
+    static constexpr std::int32_t kInvalidDay = std::numeric_limits<std::int32_t>::min();
+
+    constexpr Date() : dayNumber(kInvalidDay) {}
+    constexpr explicit Date(std::int32_t _dayNumber) : dayNumber(_dayNumber) {}
+
+    constexpr std::int32_t days() const { return dayNumber; }
+    constexpr bool isValid() const { return dayNumber != kInvalidDay; }
+    constexpr CivilDate toCivil() const { return civilFromDays(dayNumber); }
+    std::string toString() const { return isValid() ? dayToDate(dayNumber) : "--"; }
+
+    friend constexpr bool operator==(Date a, Date b) { return a.dayNumber == b.dayNumber; }
+    friend constexpr bool operator!=(Date a, Date b) { return a.dayNumber != b.dayNumber; }
+    friend constexpr bool operator<(Date a, Date b) { return a.dayNumber < b.dayNumber; }
+    friend constexpr bool operator<=(Date a, Date b) { return a.dayNumber <= b.dayNumber; }
+    friend constexpr bool operator>(Date a, Date b) { return a.dayNumber > b.dayNumber; }
+    friend constexpr bool operator>=(Date a, Date b) { return a.dayNumber >= b.dayNumber; }
+};
+
+static_assert(sizeof(Date) == 4, "Date должен занимать 32 бита");
+
+struct LocalDateTime {
+    Date date;       // по местному времени
+    TimeOfDay time;
+};
+
+inline LocalDateTime toLocalDateTime(std::chrono::system_clock::time_point tp) {
+    std::time_t tt = std::chrono::system_clock::to_time_t(tp);
+    std::tm tm = {};
+#ifdef _WIN32
+    localtime_s(&tm, &tt);
+#else
+    localtime_r(&tt, &tm);
+#endif
+    return { Date(daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday)), TimeOfDay(tm.tm_hour, tm.tm_min) };
+}
+
+// Момент по местному времени в минутах от 01-01-1970 00:00: сравнение двух
+// моментов — одно целочисленное сравнение.
+constexpr long long toLocalInstant(Date date, TimeOfDay time) {
+    return static_cast<long long>(date.days()) * 1440 + time.totalMinutes();
+}
+
+inline long long localInstantNow(std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
+    LocalDateTime local = toLocalDateTime(now);
+    return toLocalInstant(local.date, local.time);
+}
+
+#endif // CIVIL_DATE_H
@@ -0,0 +1,52 @@
+#include "client_directory.h"
+
+using namespace std;
+
+bool ClientDirectory::find(const string& name, int& id) const {
+    auto it = idsByName.find(name);
+    if (it == idsByName.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+bool ClientDirectory::contains(int id) const {
+    return id >= 0 && static_cast<size_t>(id) < present.size() && present[id];
+}
+
+const string& ClientDirectory::nameOf(int id) const {
+    static const string unknown;
+    return contains(id) ? namesById[id] : unknown;
+}
+
+void ClientDirectory::add(int id, const string& name) {
+    if (id < 0) {
+        return;
+    }
+    if (static_cast<size_t>(id) >= namesById.size()) {
+        namesById.resize(id + 1);
+        present.resize(id + 1, false);
+    }
+    if (present[id]) {
+        idsByName.erase(namesById[id]);
+    }
+    namesById[id] = name;
+    present[id] = true;
+    idsByName[name] = id;
+}
+
+void ClientDirectory::erase(int id) {
+    if (!contains(id)) {
+        return;
+    }
+    idsByName.erase(namesById[id]);
+    namesById[id].clear();
+    present[id] = false;
+}
+
+void ClientDirectory::clear() {
+    namesById.clear();
+    present.clear();
+    idsByName.clear();
+}
@@ -0,0 +1,30 @@
+#ifndef CLIENT_DIRECTORY_H
+#define CLIENT_DIRECTORY_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Словарь клиентов: ID -> имя (ID совпадает с Clients.id в базе) и
+// имя -> ID через хеш-таблицу. Брони хранят только ID клиента.
+class ClientDirectory {
+private:
+    std::vector<std::string> namesById; // индекс — ID клиента
+    std::vector<bool> present;
+    std::unordered_map<std::string, int> idsByName;
+
+public:
+    // false, если клиента с таким именем нет.
+    bool find(const std::string& name, int& id) const;
+    bool contains(int id) const;
+    // Имя клиента; пустая строка, если ID неизвестен.
+    const std::string& nameOf(int id) const;
+
+    void add(int id, const std::string& name);
+    void erase(int id);
+    void clear();
+    std::size_t size() const { return idsByName.size(); }
+};
+
+#endif // CLIENT_DIRECTORY_H
@@ -0,0 +1,64 @@
+#include "date_time_parser.h"
+
+using namespace std;
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int twoDigits(const char* p) {
+    return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+bool parseDate(string_view text, Date& date) {
+    if (text.size() != 10 || text[2] != '-' || text[5] != '-') {
+        return false;
+    }
+    const char* p = text.data();
+    if (!isDigit(p[0]) || !isDigit(p[1]) || !isDigit(p[3]) || !isDigit(p[4]) ||
+        !isDigit(p[6]) || !isDigit(p[7]) || !isDigit(p[8]) || !isDigit(p[9])) {
+        return false;
+    }
+    int dd = twoDigits(p);
+    int mm = twoDigits(p + 3);
+    int yyyy = twoDigits(p + 6) * 100 + twoDigits(p + 8);
+    if (!isValidCivilDate(yyyy, mm, dd)) {
+        return false;
+    }
+    date = Date(daysFromCivil(yyyy, mm, dd));
+    return true;
+}
+
+bool parseTime(string_view text, TimeOfDay& time) {
+    size_t colon = text.size() >= 4 ? text.size() - 3 : 0;
+    if (colon == 0 || colon > 2 || text[colon] != ':') {
+        return false;
+    }
+    const char* p = text.data();
+    if (!isDigit(p[0]) || (colon == 2 && !isDigit(p[1])) || !isDigit(p[colon + 1]) || !isDigit(p[colon + 2])) {
+        return false;
+    }
+    int hour = colon == 2 ? twoDigits(p) : p[0] - '0';
+    int minute = twoDigits(p + colon + 1);
+    if (hour > 23 || minute > 59) {
+        return false;
+    }
+    time = TimeOfDay(hour, minute);
+    return true;
+}
+
+size_t parseDates(const string_view* texts, size_t count, Date* dates) {
+    size_t failed = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!parseDate(texts[i], dates[i])) {
+            dates[i] = Date();
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+size_t parseDates(const vector<string_view>& texts, vector<Date>& dates) {
+    dates.resize(texts.size());
+    return parseDates(texts.data(), texts.size(), dates.data());
+}
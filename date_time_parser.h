@@ -0,0 +1,22 @@
+#ifndef DATE_TIME_PARSER_H
+#define DATE_TIME_PARSER_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "Time.h"
+#include "civil_date.h"
+
+// Разбор дат и времени без регулярных выражений, потоков и выделения памяти.
+// Дата: DD-MM-YYYY с проверкой по календарю (31-02 и 29-02 невисокосного года отклоняются).
+// Время: H:MM или HH:MM, 00:00..23:59.
+
+bool parseDate(std::string_view text, Date& date);
+bool parseTime(std::string_view text, TimeOfDay& time);
+
+// Пакетный разбор для импорта: dates[i] — разобранная дата или Date() (isValid() == false).
+// Возвращает количество строк, которые не удалось разобрать.
+std::size_t parseDates(const std::string_view* texts, std::size_t count, Date* dates);
+std::size_t parseDates(const std::vector<std::string_view>& texts, std::vector<Date>& dates);
+
+#endif // DATE_TIME_PARSER_H
@@ -0,0 +1,76 @@
+#include "epoch_reclaimer.h"
+#include <algorithm>
+
+using namespace std;
+
+EpochReclaimer::~EpochReclaimer() {
+    for (const Retired& r : retired) {
+        r.destroy(r.object);
+    }
+    ReaderRecord* record = records.load();
+    while (record) {
+        ReaderRecord* next = record->next;
+        delete record;
+        record = next;
+    }
+}
+
+EpochReclaimer::ReaderRecord* EpochReclaimer::acquireRecord() {
+    for (ReaderRecord* record = records.load(memory_order_acquire); record; record = record->next) {
+        bool expected = false;
+        if (!record->inUse.load(memory_order_relaxed) &&
+            record->inUse.compare_exchange_strong(expected, true, memory_order_acquire)) {
+            return record;
+        }
+    }
+    // Все записи заняты: новая добавляется в голову списка и больше не удаляется.
+    ReaderRecord* record = new ReaderRecord;
+    record->inUse.store(true, memory_order_relaxed);
+    record->next = records.load(memory_order_relaxed);
+    while (!records.compare_exchange_weak(record->next, record, memory_order_release, memory_order_relaxed)) {
+    }
+    return record;
+}
+
+EpochReclaimer::Guard EpochReclaimer::enter() {
+    ReaderRecord* record = acquireRecord();
+    // Эпоха объявляется, пока глобальная не перестанет меняться: иначе
+    // reclaim() мог не увидеть нас и удалить объект, который мы сейчас прочтём.
+    uint64_t epoch = globalEpoch.load();
+    for (;;) {
+        record->epoch.store(epoch);
+        uint64_t now = globalEpoch.load();
+        if (now == epoch) {
+            break;
+        }
+        epoch = now;
+    }
+    return Guard(record);
+}
+
+EpochReclaimer::Guard::~Guard() {
+    if (record) {
+        record->epoch.store(kIdle, memory_order_release);
+        record->inUse.store(false, memory_order_release);
+    }
+}
+
+size_t EpochReclaimer::reclaim() {
+    if (retired.empty()) {
+        return 0;
+    }
+    // Читатели, вошедшие после этого шага, объявят эпоху новее любой отметки в retired.
+    globalEpoch.fetch_add(1);
+    uint64_t oldestActive = kIdle;
+    for (ReaderRecord* record = records.load(memory_order_acquire); record; record = record->next) {
+        oldestActive = min(oldestActive, record->epoch.load());
+    }
+
+    auto keep = partition(retired.begin(), retired.end(), [&](const Retired& r) { return r.epoch >= oldestActive; });
+    size_t freed = static_cast<size_t>(retired.end() - keep);
+    for (auto it = keep; it != retired.end(); ++it) {
+        it->destroy(it->object);
+    }
+    retired.erase(keep, retired.end());
+    return freed;
+}
@@ -0,0 +1,69 @@
+#ifndef EPOCH_RECLAIMER_H
+#define EPOCH_RECLAIMER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Освобождение памяти по эпохам для читателей без блокировок. Читатель на
+// время чтения объявляет текущую эпоху (enter()); писатель, убрав объект из
+// общей структуры, отдаёт его в retire() с отметкой эпохи, а reclaim()
+// продвигает эпоху и удаляет объекты, которые не может видеть ни один
+// активный читатель. Читатели не ждут никого; retire и reclaim вызывает
+// только писатель (из одного потока за раз).
+class EpochReclaimer {
+private:
+    static constexpr std::uint64_t kIdle = UINT64_MAX;
+
+    struct alignas(64) ReaderRecord {
+        std::atomic<std::uint64_t> epoch{ kIdle };
+        std::atomic<bool> inUse{ false };
+        ReaderRecord* next = nullptr;
+    };
+
+    struct Retired {
+        std::uint64_t epoch;
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    std::atomic<std::uint64_t> globalEpoch{ 1 };
+    std::atomic<ReaderRecord*> records{ nullptr }; // список только растёт
+    std::vector<Retired> retired;
+
+    ReaderRecord* acquireRecord();
+
+public:
+    // Чтение под защитой эпохи; объекты, видимые внутри, не будут удалены
+    // до выхода. Держать недолго: пока читатель внутри, память не освобождается.
+    class Guard {
+    private:
+        ReaderRecord* record;
+
+    public:
+        explicit Guard(ReaderRecord* _record) : record(_record) {}
+        Guard(Guard&& other) noexcept : record(other.record) { other.record = nullptr; }
+        Guard& operator=(Guard&&) = delete;
+        Guard(const Guard&) = delete;
+        ~Guard();
+    };
+
+    EpochReclaimer() = default;
+    // Удаляет всё отложенное: читателей к этому моменту быть не должно.
+    ~EpochReclaimer();
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    Guard enter();
+
+    template <typename T>
+    void retire(const T* object) {
+        retired.push_back({ globalEpoch.load(), const_cast<T*>(object), [](void* p) { delete static_cast<T*>(p); } });
+    }
+    // Возвращает число удалённых объектов.
+    std::size_t reclaim();
+    std::size_t pending() const { return retired.size(); }
+};
+
+#endif // EPOCH_RECLAIMER_H
@@ -0,0 +1,114 @@
+#include "expiry_scheduler.h"
+#include "booking.h"
+#include "civil_date.h"
+#include <chrono>
+#include <utility>
+
+using namespace std;
+
+ExpiryScheduler::ExpiryScheduler(const StorageConfig& storage)
+    : manager(make_unique<BookingManager>(storage)), wheel(localInstantNow()) {
+    worker = thread(&ExpiryScheduler::run, this);
+}
+
+ExpiryScheduler::~ExpiryScheduler() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeWorker.notify_one();
+    worker.join();
+}
+
+void ExpiryScheduler::schedule(int bookingId, long long endInstant) {
+    bool wake;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        wheel.schedule(bookingId, endInstant);
+        wake = wheel.hasDue();
+    }
+    if (wake) {
+        wakeWorker.notify_one();
+    }
+}
+
+void ExpiryScheduler::schedule(const Booking& b) {
+    if (b.hasValidDate()) {
+        schedule(b.getBookingId(), b.getEndInstant());
+    }
+}
+
+void ExpiryScheduler::cancel(int bookingId) {
+    lock_guard<mutex> lock(stateMutex);
+    wheel.cancel(bookingId);
+    if (writing) {
+        cancelledWhileWriting.insert(bookingId);
+    }
+}
+
+vector<PurgeResult> ExpiryScheduler::drain() {
+    lock_guard<mutex> lock(stateMutex);
+    vector<PurgeResult> result(make_move_iterator(inbox.begin()), make_move_iterator(inbox.end()));
+    inbox.clear();
+    return result;
+}
+
+size_t ExpiryScheduler::pending() const {
+    lock_guard<mutex> lock(stateMutex);
+    return wheel.size();
+}
+
+ExpiryStats ExpiryScheduler::getStats() const {
+    lock_guard<mutex> lock(stateMutex);
+    return stats;
+}
+
+void ExpiryScheduler::run() {
+    vector<int> fired;
+    unique_lock<mutex> lock(stateMutex);
+    while (true) {
+        auto nextMinute = chrono::time_point_cast<chrono::minutes>(chrono::system_clock::now()) + chrono::minutes(1);
+        wakeWorker.wait_until(lock, nextMinute, [this] { return stopping || wheel.hasDue(); });
+        if (stopping) {
+            return;
+        }
+
+        auto now = chrono::system_clock::now();
+        fired.clear();
+        wheel.advance(localInstantNow(now), fired);
+        if (fired.empty()) {
+            continue;
+        }
+
+        writing = true;
+        cancelledWhileWriting.clear();
+        lock.unlock();
+        PurgeResult result;
+        bool written = true;
+        try {
+            result = manager->expireBookings(fired, now);
+        } catch (...) {
+            written = false;
+        }
+        lock.lock();
+        writing = false;
+
+        stats.fired += fired.size();
+        if (!written) {
+            // База занята или недоступна: повторяем через минуту, если бронь
+            // тем временем не отменили и не перенесли.
+            ++stats.failedBatches;
+            for (int bookingId : fired) {
+                if (!wheel.contains(bookingId) && !cancelledWhileWriting.count(bookingId)) {
+                    wheel.schedule(bookingId, wheel.now() + 1);
+                }
+            }
+            continue;
+        }
+        stats.expired += result.bookingIds.size();
+        stats.released += result.releasedWorkstationIds.size();
+        if (!result.bookingIds.empty()) {
+            inbox.push_back(move(result));
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef EXPIRY_SCHEDULER_H
+#define EXPIRY_SCHEDULER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "booking_manager.h"
+#include "storage_config.h"
+#include "timer_wheel.h"
+
+class Booking;
+
+struct ExpiryStats {
+    std::size_t fired = 0;          // сработало таймеров
+    std::size_t expired = 0;        // из них бронь действительно удалена
+    std::size_t released = 0;       // станций переведено в available
+    std::size_t failedBatches = 0;  // пачек, не записанных в базу (повтор через минуту)
+};
+
+// Истечение броней по таймерам. Фоновый поток владеет своим соединением с
+// базой, просыпается на границе каждой минуты, забирает из колеса таймеров
+// (TimerWheel) брони, закончившиеся к этому моменту, и одной транзакцией
+// удаляет их и освобождает станции (BookingManager::expireBookings).
+// Результаты складываются во входящую очередь, которую поток интерфейса
+// забирает через drain(), чтобы обновить свои данные в памяти.
+class ExpiryScheduler {
+private:
+    std::unique_ptr<BookingManager> manager;
+    mutable std::mutex stateMutex;
+    std::condition_variable wakeWorker;
+    TimerWheel wheel;
+    std::deque<PurgeResult> inbox;
+    // Пока пачка пишется в базу без блокировки: отменённые за это время брони,
+    // чтобы при неудачной записи не поставить их снова.
+    bool writing = false;
+    std::unordered_set<int> cancelledWhileWriting;
+    ExpiryStats stats;
+    bool stopping = false;
+    std::thread worker;
+
+    void run();
+
+public:
+    explicit ExpiryScheduler(const StorageConfig& storage = StorageConfig::durableFast());
+    ~ExpiryScheduler();
+    ExpiryScheduler(const ExpiryScheduler&) = delete;
+    ExpiryScheduler& operator=(const ExpiryScheduler&) = delete;
+
+    // endInstant — конец брони в минутах местного времени (см. toLocalInstant).
+    // Повторный вызов для той же брони заменяет срок.
+    void schedule(int bookingId, long long endInstant);
+    // Бронь с некорректной датой не ставится.
+    void schedule(const Booking& b);
+    void cancel(int bookingId);
+
+    // Забирает результаты, записанные в базу с прошлого вызова.
+    std::vector<PurgeResult> drain();
+
+    std::size_t pending() const;
+    ExpiryStats getStats() const;
+};
+
+#endif // EXPIRY_SCHEDULER_H
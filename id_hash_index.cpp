@@ -0,0 +1,99 @@
+#include "id_hash_index.h"
+
+using namespace std;
+
+size_t IdHashIndex::home(int id) const {
+    // Фибоначчиево хеширование: соседние ID расходятся по всей таблице.
+    uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(id)) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(hash >> 32) & (table.size() - 1);
+}
+
+void IdHashIndex::rehash(size_t newCapacity) {
+    vector<Entry> old;
+    old.swap(table);
+    table.assign(newCapacity, Entry{ 0, kEmpty });
+    for (const Entry& entry : old) {
+        if (entry.slot == kEmpty) {
+            continue;
+        }
+        size_t i = home(entry.id);
+        while (table[i].slot != kEmpty) {
+            i = (i + 1) & (table.size() - 1);
+        }
+        table[i] = entry;
+    }
+}
+
+bool IdHashIndex::find(int id, uint32_t& slot) const {
+    if (table.empty()) {
+        return false;
+    }
+    for (size_t i = home(id); table[i].slot != kEmpty; i = (i + 1) & (table.size() - 1)) {
+        if (table[i].id == id) {
+            slot = table[i].slot;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IdHashIndex::contains(int id) const {
+    uint32_t slot;
+    return find(id, slot);
+}
+
+bool IdHashIndex::insert(int id, uint32_t slot) {
+    if ((count + 1) * 2 > table.size()) {
+        rehash(table.empty() ? 16 : table.size() * 2);
+    }
+    size_t i = home(id);
+    for (; table[i].slot != kEmpty; i = (i + 1) & (table.size() - 1)) {
+        if (table[i].id == id) {
+            return false;
+        }
+    }
+    table[i] = Entry{ id, slot };
+    ++count;
+    return true;
+}
+
+bool IdHashIndex::erase(int id) {
+    if (table.empty()) {
+        return false;
+    }
+    const size_t mask = table.size() - 1;
+    size_t hole = home(id);
+    while (table[hole].slot != kEmpty && table[hole].id != id) {
+        hole = (hole + 1) & mask;
+    }
+    if (table[hole].slot == kEmpty) {
+        return false;
+    }
+    // Сдвигаем назад записи, чья исходная позиция не лежит в (hole, next].
+    for (size_t next = (hole + 1) & mask; table[next].slot != kEmpty; next = (next + 1) & mask) {
+        size_t wanted = home(table[next].id);
+        bool staysAfterHole = hole <= next ? (hole < wanted && wanted <= next) : (hole < wanted || wanted <= next);
+        if (!staysAfterHole) {
+            table[hole] = table[next];
+            hole = next;
+        }
+    }
+    table[hole].slot = kEmpty;
+    --count;
+    return true;
+}
+
+void IdHashIndex::reserve(size_t expected) {
+    size_t capacity = 16;
+    while (capacity < expected * 2) {
+        capacity *= 2;
+    }
+    if (capacity > table.size()) {
+        rehash(capacity);
+    }
+}
+
+void IdHashIndex::clear() {
+    table.clear();
+    count = 0;
+}
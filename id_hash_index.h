@@ -0,0 +1,38 @@
+#ifndef ID_HASH_INDEX_H
+#define ID_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Хеш-таблица ID -> номер слота с открытой адресацией (линейное пробирование).
+// Удаление сдвигает следующие записи назад, поэтому «надгробий» нет и поиск
+// не деградирует после многих удалений. Заполнение держится не выше 1/2.
+class IdHashIndex {
+private:
+    struct Entry {
+        int id;
+        std::uint32_t slot;
+    };
+
+    static constexpr std::uint32_t kEmpty = 0xFFFFFFFFu;
+
+    std::vector<Entry> table; // размер — степень двойки или 0
+    std::size_t count = 0;
+
+    std::size_t home(int id) const;
+    void rehash(std::size_t newCapacity);
+
+public:
+    bool find(int id, std::uint32_t& slot) const;
+    bool contains(int id) const;
+    // false, если ID уже есть (запись не меняется).
+    bool insert(int id, std::uint32_t slot);
+    bool erase(int id);
+
+    void reserve(std::size_t expected);
+    void clear();
+    std::size_t size() const { return count; }
+};
+
+#endif // ID_HASH_INDEX_H
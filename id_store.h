@@ -0,0 +1,127 @@
+#ifndef ID_STORE_H
+#define ID_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <vector>
+#include "id_hash_index.h"
+
+// Хранилище объектов со стабильными слотами: объект не перемещается, пока
+// не удалён (слоты в std::deque, рост не переносит старые объекты, и
+// указатели из find/add остаются верными), освободившиеся слоты переиспользуются. Поиск по ID — O(1)
+// через IdHashIndex. IdOf — метод T или свободная функция, возвращающая ID объекта.
+template <typename T, auto IdOf>
+class IdStore {
+private:
+    std::deque<std::optional<T>> slots;
+    std::vector<std::uint32_t> freeSlots;
+    IdHashIndex index;
+
+    template <typename Slots, typename Value>
+    class SlotIterator {
+    private:
+        Slots* slots;
+        std::size_t pos;
+
+        void skipEmpty() {
+            while (pos < slots->size() && !(*slots)[pos]) {
+                ++pos;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        SlotIterator(Slots* _slots, std::size_t _pos) : slots(_slots), pos(_pos) { skipEmpty(); }
+
+        reference operator*() const { return *(*slots)[pos]; }
+        pointer operator->() const { return &*(*slots)[pos]; }
+        SlotIterator& operator++() { ++pos; skipEmpty(); return *this; }
+        bool operator==(const SlotIterator& other) const { return pos == other.pos; }
+        bool operator!=(const SlotIterator& other) const { return pos != other.pos; }
+    };
+
+public:
+    using iterator = SlotIterator<std::deque<std::optional<T>>, T>;
+    using const_iterator = SlotIterator<const std::deque<std::optional<T>>, const T>;
+
+    T* find(int id) {
+        std::uint32_t slot;
+        return index.find(id, slot) ? &*slots[slot] : nullptr;
+    }
+
+    const T* find(int id) const {
+        std::uint32_t slot;
+        return index.find(id, slot) ? &*slots[slot] : nullptr;
+    }
+
+    bool contains(int id) const { return index.contains(id); }
+
+    // nullptr, если объект с таким ID уже есть.
+    T* add(const T& item) {
+        int id = std::invoke(IdOf, item);
+        if (index.contains(id)) {
+            return nullptr;
+        }
+        std::uint32_t slot;
+        if (freeSlots.empty()) {
+            slot = static_cast<std::uint32_t>(slots.size());
+            slots.emplace_back(item);
+        } else {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[slot].emplace(item);
+        }
+        index.insert(id, slot);
+        return &*slots[slot];
+    }
+
+    bool erase(int id) {
+        std::uint32_t slot;
+        if (!index.find(id, slot)) {
+            return false;
+        }
+        index.erase(id);
+        slots[slot].reset();
+        freeSlots.push_back(slot);
+        return true;
+    }
+
+    // Заменяет объект на месте; ID нового объекта должен совпадать с id.
+    T* replace(int id, const T& item) {
+        std::uint32_t slot;
+        if (std::invoke(IdOf, item) != id || !index.find(id, slot)) {
+            return nullptr;
+        }
+        slots[slot].emplace(item);
+        return &*slots[slot];
+    }
+
+    void reserve(std::size_t expected) {
+        index.reserve(expected);
+    }
+
+    void clear() {
+        slots.clear();
+        freeSlots.clear();
+        index.clear();
+    }
+
+    std::size_t size() const { return index.size(); }
+    bool empty() const { return index.size() == 0; }
+
+    iterator begin() { return iterator(&slots, 0); }
+    iterator end() { return iterator(&slots, slots.size()); }
+    const_iterator begin() const { return const_iterator(&slots, 0); }
+    const_iterator end() const { return const_iterator(&slots, slots.size()); }
+};
+
+#endif // ID_STORE_H
@@ -0,0 +1,121 @@
+#include "interval_index.h"
+#include "booking.h"
+#include <algorithm>
+
+using namespace std;
+
+uint64_t IntervalIndex::makeKey(int workstationId, Date day) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(workstationId)) << 32) | static_cast<uint32_t>(day.days());
+}
+
+void IntervalIndex::insert(int workstationId, Date day, const BookingInterval& interval) {
+    Bucket& bucket = buckets[makeKey(workstationId, day)];
+    auto pos = upper_bound(bucket.intervals.begin(), bucket.intervals.end(), interval.start,
+                           [](TimeOfDay start, const BookingInterval& item) { return start < item.start; });
+    bucket.intervals.insert(pos, interval);
+    setRange(bucket.occupancy, interval.start.totalMinutes(), interval.end.totalMinutes());
+    bucket.maxLength = max(bucket.maxLength, interval.end.totalMinutes() - interval.start.totalMinutes());
+    ++count;
+}
+
+bool IntervalIndex::erase(int workstationId, Date day, TimeOfDay start, int bookingId) {
+    auto it = buckets.find(makeKey(workstationId, day));
+    if (it == buckets.end()) {
+        return false;
+    }
+    Bucket& bucket = it->second;
+    vector<BookingInterval>& intervals = bucket.intervals;
+    auto pos = lower_bound(intervals.begin(), intervals.end(), start,
+                           [](const BookingInterval& item, TimeOfDay value) { return item.start < value; });
+    for (; pos != intervals.end() && pos->start == start; ++pos) {
+        if (pos->bookingId != bookingId) {
+            continue;
+        }
+        int startMinute = start.totalMinutes();
+        int endMinute = pos->end.totalMinutes();
+        intervals.erase(pos);
+        --count;
+        if (intervals.empty()) {
+            buckets.erase(it);
+            return true;
+        }
+        // Освобождаем минуты брони и возвращаем те, что заняты пересекавшимися с ней бронями.
+        clearRange(bucket.occupancy, startMinute, endMinute);
+        auto other = upper_bound(intervals.begin(), intervals.end(), startMinute - bucket.maxLength,
+                                 [](int value, const BookingInterval& item) { return value < item.start.totalMinutes(); });
+        for (; other != intervals.end() && other->start.totalMinutes() < endMinute; ++other) {
+            if (other->end.totalMinutes() > startMinute) {
+                setRange(bucket.occupancy, max(other->start.totalMinutes(), startMinute), min(other->end.totalMinutes(), endMinute));
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+vector<int> IntervalIndex::findOverlaps(int workstationId, Date day, TimeOfDay start, TimeOfDay end,
+                                        int excludeBookingId) const {
+    vector<int> result;
+    auto it = buckets.find(makeKey(workstationId, day));
+    if (it == buckets.end()) {
+        return result;
+    }
+    const Bucket& bucket = it->second;
+    if (!anyInRange(bucket.occupancy, start.totalMinutes(), end.totalMinutes())) {
+        return result;
+    }
+    // Бронь, начавшаяся раньше start - maxLength, закончилась до start.
+    int firstCandidate = start.totalMinutes() - bucket.maxLength;
+    auto pos = upper_bound(bucket.intervals.begin(), bucket.intervals.end(), firstCandidate,
+                           [](int value, const BookingInterval& item) { return value < item.start.totalMinutes(); });
+    for (; pos != bucket.intervals.end() && pos->start < end; ++pos) {
+        if (pos->end > start && pos->bookingId != excludeBookingId) {
+            result.push_back(pos->bookingId);
+        }
+    }
+    return result;
+}
+
+bool IntervalIndex::isFree(int workstationId, Date day, TimeOfDay start, TimeOfDay end) const {
+    auto it = buckets.find(makeKey(workstationId, day));
+    return it == buckets.end() || !anyInRange(it->second.occupancy, start.totalMinutes(), end.totalMinutes());
+}
+
+vector<int> IntervalIndex::findFreeStations(const vector<int>& workstationIds, Date day, TimeOfDay start, TimeOfDay end) const {
+    const DayBitmap mask = rangeMask(start.totalMinutes(), end.totalMinutes());
+    vector<int> result;
+    result.reserve(workstationIds.size());
+    for (int workstationId : workstationIds) {
+        auto it = buckets.find(makeKey(workstationId, day));
+        if (it == buckets.end() || !intersects(it->second.occupancy, mask)) {
+            result.push_back(workstationId);
+        }
+    }
+    return result;
+}
+
+void IntervalIndex::insert(const Booking& b) {
+    if (b.hasValidDate()) {
+        insert(b.getWorkstationId(), b.getBookingDate(), { b.getStartTime(), b.getEndTime(), b.getBookingId() });
+    }
+}
+
+bool IntervalIndex::erase(const Booking& b) {
+    if (!b.hasValidDate()) {
+        return false;
+    }
+    return erase(b.getWorkstationId(), b.getBookingDate(), b.getStartTime(), b.getBookingId());
+}
+
+vector<int> IntervalIndex::findOverlaps(const Booking& candidate) const {
+    if (!candidate.hasValidDate()) {
+        return vector<int>();
+    }
+    return findOverlaps(candidate.getWorkstationId(), candidate.getBookingDate(), candidate.getStartTime(),
+                        candidate.getEndTime(), candidate.getBookingId());
+}
+
+void IntervalIndex::clear() {
+    buckets.clear();
+    count = 0;
+}
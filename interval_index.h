@@ -0,0 +1,63 @@
+#ifndef INTERVAL_INDEX_H
+#define INTERVAL_INDEX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "occupancy_bitmap.h"
+#include "Time.h"
+#include "civil_date.h"
+
+class Booking;
+
+struct BookingInterval {
+    TimeOfDay start;
+    TimeOfDay end;
+    int bookingId;
+};
+
+// Индекс броней по (станция, день): в каждой корзине интервалы отсортированы
+// по началу, поэтому поиск пересечений — двоичный поиск плюс проход только
+// по кандидатам, O(log n + k). Для корзины хранится максимальная длина брони,
+// чтобы поиск оставался верным и при пересекающихся старых данных.
+// Рядом с интервалами корзина держит битовую карту занятости суток:
+// «свободно ли» отвечается по нескольким словам без обхода броней.
+class IntervalIndex {
+private:
+    struct Bucket {
+        DayBitmap occupancy;
+        std::vector<BookingInterval> intervals;
+        int maxLength = 0;
+    };
+
+    std::unordered_map<std::uint64_t, Bucket> buckets;
+    std::size_t count = 0;
+
+    static std::uint64_t makeKey(int workstationId, Date day);
+
+public:
+    void insert(int workstationId, Date day, const BookingInterval& interval);
+    bool erase(int workstationId, Date day, TimeOfDay start, int bookingId);
+
+    // Все брони станции за день, пересекающиеся с [start, end),
+    // кроме excludeBookingId (для проверки при обновлении брони).
+    std::vector<int> findOverlaps(int workstationId, Date day, TimeOfDay start, TimeOfDay end,
+                                  int excludeBookingId = -1) const;
+
+    bool isFree(int workstationId, Date day, TimeOfDay start, TimeOfDay end) const;
+
+    // Массовый запрос по битовым картам: маска интервала строится один раз.
+    // Порядок ID сохраняется.
+    std::vector<int> findFreeStations(const std::vector<int>& workstationIds, Date day, TimeOfDay start, TimeOfDay end) const;
+
+    // Варианты для Booking: бронь с неверной датой игнорируется.
+    void insert(const Booking& b);
+    bool erase(const Booking& b);
+    std::vector<int> findOverlaps(const Booking& candidate) const;
+
+    void clear();
+    std::size_t size() const { return count; }
+};
+
+#endif // INTERVAL_INDEX_H
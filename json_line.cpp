@@ -0,0 +1,286 @@
+#include "json_line.h"
+#include <limits>
+
+using namespace std;
+
+static void skipSpaces(string_view line, size_t& pos) {
+    while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r' || line[pos] == '\n')) {
+        ++pos;
+    }
+}
+
+static bool parseHex4(string_view line, size_t& pos, unsigned& code) {
+    if (pos + 4 > line.size()) {
+        return false;
+    }
+    code = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        char c = line[pos + i];
+        code <<= 4;
+        if (c >= '0' && c <= '9') {
+            code |= static_cast<unsigned>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            code |= static_cast<unsigned>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            code |= static_cast<unsigned>(c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+    pos += 4;
+    return true;
+}
+
+static void appendUtf8(string& out, unsigned code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+// pos указывает на открывающую кавычку.
+static bool parseString(string_view line, size_t& pos, string& out, string& error) {
+    ++pos;
+    out.clear();
+    while (pos < line.size()) {
+        // Обычные символы копируются участками, без разбора по одному.
+        size_t runEnd = line.find_first_of("\"\\", pos);
+        if (runEnd == string_view::npos) {
+            break;
+        }
+        out.append(line.data() + pos, runEnd - pos);
+        pos = runEnd;
+        if (line[pos] == '"') {
+            ++pos;
+            return true;
+        }
+        if (++pos >= line.size()) {
+            break;
+        }
+        char escaped = line[pos++];
+        switch (escaped) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned code;
+                if (!parseHex4(line, pos, code)) {
+                    error = "неверная последовательность \\u";
+                    return false;
+                }
+                if (code >= 0xD800 && code < 0xDC00) {
+                    unsigned low;
+                    if (pos + 2 > line.size() || line[pos] != '\\' || line[pos + 1] != 'u') {
+                        error = "непарный суррогат в \\u";
+                        return false;
+                    }
+                    pos += 2;
+                    if (!parseHex4(line, pos, low) || low < 0xDC00 || low > 0xDFFF) {
+                        error = "непарный суррогат в \\u";
+                        return false;
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                error = "неизвестная escape-последовательность";
+                return false;
+        }
+    }
+    error = "незакрытая строка";
+    return false;
+}
+
+static bool parseNumber(string_view line, size_t& pos, long long& number, string& error) {
+    bool negative = false;
+    if (line[pos] == '-') {
+        negative = true;
+        ++pos;
+    }
+    if (pos >= line.size() || line[pos] < '0' || line[pos] > '9') {
+        error = "неверное число";
+        return false;
+    }
+    unsigned long long value = 0;
+    const unsigned long long limit = static_cast<unsigned long long>(numeric_limits<long long>::max()) + (negative ? 1 : 0);
+    while (pos < line.size() && line[pos] >= '0' && line[pos] <= '9') {
+        unsigned long long digit = static_cast<unsigned long long>(line[pos] - '0');
+        // Проверка до умножения: после него unsigned мог уже переполниться.
+        if (value > (limit - digit) / 10) {
+            error = "число вне диапазона";
+            return false;
+        }
+        value = value * 10 + digit;
+        ++pos;
+    }
+    if (pos < line.size() && (line[pos] == '.' || line[pos] == 'e' || line[pos] == 'E')) {
+        error = "поддерживаются только целые числа";
+        return false;
+    }
+    number = negative ? static_cast<long long>(0 - value) : static_cast<long long>(value);
+    return true;
+}
+
+static bool parseLiteral(string_view line, size_t& pos, string_view literal) {
+    if (line.substr(pos, literal.size()) != literal) {
+        return false;
+    }
+    pos += literal.size();
+    return true;
+}
+
+bool JsonLine::parse(string_view line, string& error) {
+    fields.clear();
+    size_t pos = 0;
+    skipSpaces(line, pos);
+    if (pos >= line.size() || line[pos] != '{') {
+        error = "ожидался объект JSON";
+        return false;
+    }
+    ++pos;
+    skipSpaces(line, pos);
+    if (pos < line.size() && line[pos] == '}') {
+        ++pos;
+    } else {
+        while (true) {
+            skipSpaces(line, pos);
+            if (pos >= line.size() || line[pos] != '"') {
+                error = "ожидалось имя поля";
+                return false;
+            }
+            pair<string, JsonValue> field;
+            if (!parseString(line, pos, field.first, error)) {
+                return false;
+            }
+            skipSpaces(line, pos);
+            if (pos >= line.size() || line[pos] != ':') {
+                error = "ожидалось ':' после имени поля";
+                return false;
+            }
+            ++pos;
+            skipSpaces(line, pos);
+            if (pos >= line.size()) {
+                error = "ожидалось значение";
+                return false;
+            }
+
+            JsonValue& value = field.second;
+            char c = line[pos];
+            if (c == '"') {
+                value.type = JsonType::String;
+                if (!parseString(line, pos, value.text, error)) {
+                    return false;
+                }
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+                value.type = JsonType::Number;
+                if (!parseNumber(line, pos, value.number, error)) {
+                    return false;
+                }
+            } else if (parseLiteral(line, pos, "true")) {
+                value.type = JsonType::Bool;
+                value.boolean = true;
+            } else if (parseLiteral(line, pos, "false")) {
+                value.type = JsonType::Bool;
+            } else if (parseLiteral(line, pos, "null")) {
+                value.type = JsonType::Null;
+            } else if (c == '{' || c == '[') {
+                error = "вложенные объекты и массивы не поддерживаются";
+                return false;
+            } else {
+                error = "неверное значение поля";
+                return false;
+            }
+            fields.push_back(move(field));
+
+            skipSpaces(line, pos);
+            if (pos < line.size() && line[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            if (pos < line.size() && line[pos] == '}') {
+                ++pos;
+                break;
+            }
+            error = "ожидалось ',' или '}'";
+            return false;
+        }
+    }
+    skipSpaces(line, pos);
+    if (pos != line.size()) {
+        error = "лишние символы после объекта";
+        return false;
+    }
+    return true;
+}
+
+// Полей в команде единицы — линейный поиск быстрее хеш-таблицы.
+const JsonValue* JsonLine::find(string_view key) const {
+    for (const auto& field : fields) {
+        if (field.first == key) {
+            return &field.second;
+        }
+    }
+    return nullptr;
+}
+
+bool JsonLine::getInt(string_view key, int& value) const {
+    const JsonValue* field = find(key);
+    if (!field || field->type != JsonType::Number || field->number < numeric_limits<int>::min() ||
+        field->number > numeric_limits<int>::max()) {
+        return false;
+    }
+    value = static_cast<int>(field->number);
+    return true;
+}
+
+bool JsonLine::getString(string_view key, string& value) const {
+    const JsonValue* field = find(key);
+    if (!field || field->type != JsonType::String) {
+        return false;
+    }
+    value = field->text;
+    return true;
+}
+
+void appendJsonString(string& out, string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else if (u < 0x20) {
+            out += "\\u00";
+            out += hex[u >> 4];
+            out += hex[u & 0xF];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
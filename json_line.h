@@ -0,0 +1,47 @@
+#ifndef JSON_LINE_H
+#define JSON_LINE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+enum class JsonType : std::uint8_t {
+    Null,
+    Bool,
+    Number,
+    String
+};
+
+struct JsonValue {
+    JsonType type = JsonType::Null;
+    bool boolean = false;
+    long long number = 0;
+    std::string text;
+};
+
+// Одна строка JSONL — плоский объект {"ключ": значение, ...} со строками,
+// целыми числами, true/false и null. Вложенные объекты, массивы и дробные
+// числа командам не нужны и считаются ошибкой.
+class JsonLine {
+private:
+    std::vector<std::pair<std::string, JsonValue>> fields;
+
+public:
+    // При ошибке возвращает false и пишет причину в error.
+    bool parse(std::string_view line, std::string& error);
+
+    const JsonValue* find(std::string_view key) const;
+    bool has(std::string_view key) const { return find(key) != nullptr; }
+    // false, если поля нет или оно другого типа.
+    bool getInt(std::string_view key, int& value) const;
+    bool getString(std::string_view key, std::string& value) const;
+
+    std::size_t size() const { return fields.size(); }
+};
+
+// Дописывает text в out как строку JSON в кавычках.
+void appendJsonString(std::string& out, std::string_view text);
+
+#endif // JSON_LINE_H
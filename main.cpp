@@ -6,127 +6,78 @@
 #include <ios>
 #include <chrono>
 #include <algorithm>
-#include <vector>
-#include <regex>
 #include <iomanip>
+#include <optional>
+#include <fstream>
+#include <cstring>
 
-#include "time.h"
+#include "Time.h"
 #include "workstation.h"
 #include "booking.h"
-#include "booking_manager.h"
+#include "civil_date.h"
+#include "date_time_parser.h"
+#include "workstation_status.h"
+#include "booking_engine.h"
+#include "batch_runner.h"
 
+#ifdef _WIN32
 #define NOMINMAX
 #include <windows.h>
+#endif
 
 using namespace std;
 
-bool parseTimeHHMM(const string& timeStr, Time& resultTime) {
-    regex time_regex("^([01]?[0-9]|2[0-3]):([0-5][0-9])$");
-    smatch match;
-    if (regex_match(timeStr, match, time_regex) && match.size() == 3) {
-        try {
-            resultTime.hour = stoi(match[1].str());
-            resultTime.minute = stoi(match[2].str());
-            return true;
-        } catch (const std::exception& e) {
-            cerr << "Ошибка преобразования времени: " << e.what() << endl;
-            return false;
-        }
+void printConflict(const string& prefix, int workstationId, const vector<int>& conflictingIds) {
+    cerr << prefix << " Станция " << workstationId
+         << " уже забронирована в это время (ID существующих броней: ";
+    for (size_t i = 0; i < conflictingIds.size(); ++i) {
+        cerr << (i ? ", " : "") << conflictingIds[i];
     }
-    return false;
+    cerr << ")." << endl;
 }
 
-bool isValidDateFormat(const string& dateStr) {
-    regex date_regex("^([0-2][0-9]|3[01])-(0[1-9]|1[0-2])-([0-9]{4})$");
-    return regex_match(dateStr, date_regex);
+void printPurge(const PurgeResult& purged) {
+    for (int expiredId : purged.bookingIds) {
+        cout << "Бронирование ID " << expiredId << " удалено (просрочено)." << endl;
+    }
+    for (int wsId : purged.releasedWorkstationIds) {
+        cout << "Статус станции ID " << wsId << " изменен на 'available' (нет активных броней)." << endl;
+    }
 }
 
-void checkAndRemoveExpiredBookings(BookingManager& manager, vector<Booking>& bookingArray, vector<Workstation>& wsArray) {
-    auto now = chrono::system_clock::now();
-    vector<int> expiredBookingIds;
-    vector<int> affectedWorkstationIds;
-    bool expiredFound = false;
+// Показывает то, что фоновый поток истечения успел удалить с прошлого раза.
+void printExpiredBookings(BookingEngine& engine) {
+    for (const PurgeResult& purged : engine.collectExpired()) {
+        printPurge(purged);
+    }
+}
 
+void checkAndRemoveExpiredBookings(BookingEngine& engine) {
     cout << "\nПроверка просроченных бронирований..." << endl;
 
-    for (const auto& booking : bookingArray) {
-        auto endTimePoint = booking.getEndDateTime();
-        if (endTimePoint != chrono::system_clock::time_point::min() && endTimePoint < now) {
-            expiredBookingIds.push_back(booking.getBookingId());
-            affectedWorkstationIds.push_back(booking.getWorkstationId());
-            cout << "Обнаружено просроченное бронирование ID: " << booking.getBookingId() << " для станции " << booking.getWorkstationId() << endl;
-            expiredFound = true;
-        }
+    PurgeResult purged;
+    try {
+        purged = engine.purgeExpired();
+    } catch (const exception& e) {
+        cerr << "Ошибка при удалении просроченных бронирований: " << e.what() << endl;
+        return;
     }
 
-    if (!expiredFound) {
+    if (purged.bookingIds.empty()) {
         cout << "Просроченных бронирований не найдено." << endl;
         return;
     }
 
-    for (int expiredId : expiredBookingIds) {
-        try {
-            manager.deleteBooking(expiredId);
-            bookingArray.erase(remove_if(bookingArray.begin(), bookingArray.end(),
-                                         [expiredId](const Booking& b){ return b.getBookingId() == expiredId; }),
-                               bookingArray.end());
-            cout << "Бронирование ID " << expiredId << " удалено (просрочено)." << endl;
-        } catch (const exception& e) {
-            cerr << "Ошибка при удалении просроченного бронирования ID " << expiredId << ": " << e.what() << endl;
-        }
-    }
-
-    sort(affectedWorkstationIds.begin(), affectedWorkstationIds.end());
-    affectedWorkstationIds.erase(unique(affectedWorkstationIds.begin(), affectedWorkstationIds.end()), affectedWorkstationIds.end());
-
-    for (int wsId : affectedWorkstationIds) {
-        bool hasActiveOrFutureBookings = false;
-        auto checkTime = chrono::system_clock::now();
-        for (const auto& booking : bookingArray) {
-            if (booking.getWorkstationId() == wsId) {
-                auto bookingEndTime = booking.getEndDateTime();
-                if (bookingEndTime != chrono::system_clock::time_point::min() && bookingEndTime >= checkTime) {
-                    hasActiveOrFutureBookings = true;
-                    break;
-                }
-            }
-        }
-
-        if (!hasActiveOrFutureBookings) {
-            for (auto& ws : wsArray) {
-                if (ws.getId() == wsId && ws.getStatus() == "booked") {
-                    try {
-                        manager.updateWorkstationStatus(wsId, "available");
-                        ws.updateStatus("available");
-                        cout << "Статус станции ID " << wsId << " изменен на 'available' (нет активных броней)." << endl;
-                    } catch (const exception& e) {
-                         cerr << "Ошибка при обновлении статуса станции ID " << wsId << ": " << e.what() << endl;
-                    }
-                    break;
-                }
-            }
-        }
-    }
-     cout << "Проверка просроченных бронирований завершена." << endl;
+    printPurge(purged);
+    cout << "Проверка просроченных бронирований завершена." << endl;
 }
 
-void manageData(BookingManager &manager) {
-    vector<Workstation> wsArray;
-    vector<Booking> bookingArray;
-
-    try {
-        wsArray = manager.loadWorkstations();
-        bookingArray = manager.loadBookings();
-        cout << "Данные успешно загружены из booking.db." << endl;
-    } catch (const exception& e) {
-        cerr << "Критическая ошибка при загрузке данных: " << e.what() << endl;
-        return;
-    }
-
-    checkAndRemoveExpiredBookings(manager, bookingArray, wsArray);
+void manageData(BookingEngine &engine) {
+    checkAndRemoveExpiredBookings(engine);
 
     int choice;
     while (true) {
+        printExpiredBookings(engine);
         cout << "\n===== Главное меню =====\n";
         cout << "1. Управление рабочими станциями\n";
         cout << "2. Управление бронированиями\n";
@@ -150,11 +101,14 @@ void manageData(BookingManager &manager) {
             case 1: {
                 int wsChoice;
                 while (true) {
+                    printExpiredBookings(engine);
                     cout << "\n===== Меню рабочих станций =====\n";
                     cout << "1. Показать все рабочие станции\n";
                     cout << "2. Добавить рабочую станцию\n";
                     cout << "3. Удалить рабочую станцию\n";
                     cout << "4. Обновить статус рабочей станции\n";
+                    cout << "5. Показать свободные рабочие станции\n";
+                    cout << "6. Показать премиум-станции по рейтингу\n";
                     cout << "0. Вернуться в главное меню\n";
                     cout << "Выберите действие: ";
 
@@ -172,12 +126,15 @@ void manageData(BookingManager &manager) {
                         switch (wsChoice) {
                             case 1: {
                                 cout << "\n--- Список рабочих станций ---\n";
-                                if (wsArray.empty()) {
+                                if (engine.getWorkstations().empty()) {
                                     cout << "Рабочие станции не найдены." << endl;
                                 } else {
-                                    for (const auto &ws : wsArray) {
-                                        ws.display();
+                                    for (const auto &ws : engine.getWorkstations()) {
+                                        display(ws);
                                     }
+                                    cout << "Свободно: " << engine.countWithStatus(WorkstationStatus::Available)
+                                         << ", забронировано: " << engine.countWithStatus(WorkstationStatus::Booked)
+                                         << ", на обслуживании: " << engine.countWithStatus(WorkstationStatus::Maintenance) << endl;
                                 }
                                 break;
                             }
@@ -200,23 +157,29 @@ void manageData(BookingManager &manager) {
                                     continue;
                                 }
 
-                                bool id_exists = false;
-                                for(const auto& ws : wsArray) {
-                                    if(ws.getId() == id) {
-                                        id_exists = true;
-                                        break;
-                                    }
+                                if(engine.findWorkstation(id)) {
+                                    cout << "Ошибка: Станция с ID " << id << " уже существует." << endl;
+                                    continue;
                                 }
 
-                                if(id_exists) {
-                                    cout << "Ошибка: Станция с ID " << id << " уже существует." << endl;
+                                int rating = 0;
+                                cout << "Рейтинг производительности (0 — обычная станция): ";
+                                if (!(cin >> rating) || rating < 0) {
+                                    cin.clear();
+                                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                                    cout << "Неверный рейтинг.\n";
                                     continue;
                                 }
+                                cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-                                Workstation new_ws(id, name);
-                                manager.addWorkstation(new_ws);
-                                wsArray.push_back(new_ws);
-                                cout << "Рабочая станция добавлена." << endl;
+                                AnyWorkstation new_ws = rating > 0
+                                    ? AnyWorkstation(SpecialWorkstation(id, name, WorkstationStatus::Available, rating))
+                                    : AnyWorkstation(Workstation(id, name));
+                                if (engine.addWorkstation(new_ws).ok()) {
+                                    cout << "Рабочая станция добавлена." << endl;
+                                } else {
+                                    cout << "Ошибка: Станция с ID " << id << " уже существует." << endl;
+                                }
                                 break;
                             }
                             case 3: {
@@ -230,20 +193,8 @@ void manageData(BookingManager &manager) {
                                 }
                                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-                                size_t initial_size = wsArray.size();
-                                wsArray.erase(remove_if(wsArray.begin(), wsArray.end(),
-                                    [id_to_delete](const Workstation& ws){
-                                        return ws.getId() == id_to_delete;
-                                    }), wsArray.end());
-
-                                if (wsArray.size() < initial_size) {
-                                    manager.deleteWorkstation(id_to_delete);
+                                if (engine.deleteWorkstation(id_to_delete).ok()) {
                                     cout << "Рабочая станция удалена." << endl;
-
-                                    bookingArray.erase(remove_if(bookingArray.begin(), bookingArray.end(),
-                                        [id_to_delete](const Booking& b){
-                                            return b.getWorkstationId() == id_to_delete;
-                                        }), bookingArray.end());
                                     cout << "Связанные бронирования также удалены." << endl;
                                 } else {
                                     cout << "Станция с таким ID не найдена." << endl;
@@ -252,7 +203,7 @@ void manageData(BookingManager &manager) {
                             }
                             case 4: {
                                 int id_to_update;
-                                string newStatus;
+                                string newStatusStr;
                                 cout << "Введите ID станции для обновления: ";
                                 if (!(cin >> id_to_update)) {
                                     cin.clear();
@@ -263,27 +214,51 @@ void manageData(BookingManager &manager) {
                                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
                                 cout << "Введите новый статус (available/booked/maintenance): ";
-                                getline(cin, newStatus);
+                                getline(cin, newStatusStr);
 
-                                if (newStatus != "available" && newStatus != "booked" && newStatus != "maintenance") {
+                                WorkstationStatus newStatus;
+                                if (!parseStatus(newStatusStr, newStatus)) {
                                     cout << "Недопустимый статус. Используйте 'available', 'booked' или 'maintenance'." << endl;
                                     continue;
                                 }
 
-                                bool found = false;
-                                for (auto &ws : wsArray) {
-                                    if (ws.getId() == id_to_update) {
-                                        manager.updateWorkstationStatus(id_to_update, newStatus);
-                                        ws.updateStatus(newStatus);
-                                        found = true;
-                                        break;
-                                    }
+                                const AnyWorkstation* target_ws = engine.findWorkstation(id_to_update);
+                                WorkstationStatus oldStatus = target_ws ? baseOf(*target_ws).getStatus() : newStatus;
+                                EngineResult result = engine.setWorkstationStatus(id_to_update, newStatus);
+                                if (result.error == EngineError::WorkstationNotFound) {
+                                    cout << "Станция с таким ID не найдена." << endl;
+                                } else if (result.error == EngineError::InvalidTransition) {
+                                    cout << "Нельзя сменить статус '" << statusName(oldStatus)
+                                         << "' на '" << statusName(newStatus) << "'." << endl;
+                                } else {
+                                    cout << "Статус обновлён." << endl;
+                                }
+                                break;
+                            }
+                            case 5: {
+                                vector<int> ids = engine.workstationsWithStatus(WorkstationStatus::Available);
+                                cout << "\n--- Свободные рабочие станции (" << ids.size() << ") ---\n";
+                                for (int id : ids) {
+                                    display(*engine.findWorkstation(id));
+                                }
+                                break;
+                            }
+                            case 6: {
+                                int minRating;
+                                cout << "Минимальный рейтинг: ";
+                                if (!(cin >> minRating)) {
+                                    cin.clear();
+                                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                                    cout << "Неверный рейтинг.\n";
+                                    continue;
                                 }
+                                cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-                                if (found) {
-                                    cout << "Статус обновлён." << endl;
-                                } else {
-                                    cout << "Станция с таким ID не найдена." << endl;
+                                vector<int> ids = engine.premiumWithRatingAtLeast(minRating);
+                                cout << "\n--- Премиум-станции с рейтингом от " << minRating << " (" << ids.size()
+                                     << " из " << engine.getWorkstations().premiumCount() << ") ---\n";
+                                for (int id : ids) {
+                                    display(*engine.findWorkstation(id));
                                 }
                                 break;
                             }
@@ -300,11 +275,13 @@ void manageData(BookingManager &manager) {
             case 2: {
                 int bookChoice;
                 while (true) {
+                    printExpiredBookings(engine);
                     cout << "\n===== Меню бронирований =====\n";
                     cout << "1. Показать все бронирования\n";
                     cout << "2. Добавить бронирование\n";
                     cout << "3. Удалить бронирование\n";
                     cout << "4. Обновить бронирование\n";
+                    cout << "5. Показать бронирования на дату\n";
                     cout << "0. Вернуться в главное меню\n";
                     cout << "Выберите действие: ";
 
@@ -322,12 +299,12 @@ void manageData(BookingManager &manager) {
                         switch (bookChoice) {
                             case 1: {
                                 cout << "\n--- Список бронирований ---\n";
-                                checkAndRemoveExpiredBookings(manager, bookingArray, wsArray);
-                                if (bookingArray.empty()) {
+                                printExpiredBookings(engine);
+                                if (engine.getBookings().empty()) {
                                     cout << "Актуальные бронирования не найдены." << endl;
                                 } else {
-                                    for (const auto &b : bookingArray) {
-                                        b.display();
+                                    for (size_t row = 0; row < engine.getBookings().size(); ++row) {
+                                        engine.getBookings().rowAt(row).display(engine.getClients());
                                     }
                                 }
                                 break;
@@ -335,7 +312,7 @@ void manageData(BookingManager &manager) {
                             case 2: {
                                 int bookingId, workstationId;
                                 string clientName, bookingDateStr, startTimeStr, endTimeStr;
-                                Time start = {0, 0}, end = {0, 0};
+                                TimeOfDay start, end;
 
                                 cout << "Введите ID нового бронирования: ";
                                 if (!(cin >> bookingId)) {
@@ -346,15 +323,7 @@ void manageData(BookingManager &manager) {
                                 }
                                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-                                bool book_id_exists = false;
-                                for(const auto& b : bookingArray) {
-                                    if(b.getBookingId() == bookingId) {
-                                        book_id_exists = true;
-                                        break;
-                                    }
-                                }
-
-                                if(book_id_exists) {
+                                if(engine.findBooking(bookingId)) {
                                     cout << "Ошибка: Бронирование с ID " << bookingId << " уже существует.\n";
                                     continue;
                                 }
@@ -368,15 +337,7 @@ void manageData(BookingManager &manager) {
                                 }
                                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-                                bool ws_exists = false;
-                                for(const auto& ws : wsArray) {
-                                    if(ws.getId() == workstationId) {
-                                        ws_exists = true;
-                                        break;
-                                    }
-                                }
-
-                                if(!ws_exists) {
+                                if(!engine.findWorkstation(workstationId)) {
                                     cout << "Ошибка: Станция с ID " << workstationId << " не найдена.\n";
                                     continue;
                                 }
@@ -390,83 +351,48 @@ void manageData(BookingManager &manager) {
 
                                 cout << "Введите дату бронирования (формат DD-MM-YYYY): ";
                                 getline(cin, bookingDateStr);
-                                if (!isValidDateFormat(bookingDateStr)) {
-                                    cout << "Ошибка: Неверный формат даты. Используйте DD-MM-YYYY." << endl;
+                                Date bookingDate;
+                                if (!parseDate(bookingDateStr, bookingDate)) {
+                                    cout << "Ошибка: Неверная дата. Используйте DD-MM-YYYY (дата должна существовать)." << endl;
                                     continue;
                                 }
 
                                 cout << "Введите время начала (формат HH:MM): ";
                                 getline(cin, startTimeStr);
-                                if (!parseTimeHHMM(startTimeStr, start)) {
+                                if (!parseTime(startTimeStr, start)) {
                                     cout << "Ошибка: Неверный формат времени начала. Используйте HH:MM." << endl;
                                     continue;
                                 }
 
                                 cout << "Введите время окончания (формат HH:MM): ";
                                 getline(cin, endTimeStr);
-                                if (!parseTimeHHMM(endTimeStr, end)) {
+                                if (!parseTime(endTimeStr, end)) {
                                     cout << "Ошибка: Неверный формат времени окончания. Используйте HH:MM." << endl;
                                     continue;
                                 }
 
-                                if (start.hour * 60 + start.minute >= end.hour * 60 + end.minute) {
+                                if (start >= end) {
                                     cout << "Ошибка: Время начала должно быть раньше времени окончания.\n";
                                     continue;
                                 }
 
-                                Booking new_b(bookingId, workstationId, clientName, bookingDateStr, start, end);
-                                auto endTimePoint = new_b.getEndDateTime();
-
-                                if (endTimePoint != chrono::system_clock::time_point::min() &&
-                                    endTimePoint < chrono::system_clock::now()) {
+                                EngineResult result = engine.addBooking(
+                                    BookingRequest{ bookingId, workstationId, clientName, bookingDate, start, end });
+                                if (result.error == EngineError::InPast) {
                                     cout << "Ошибка: Нельзя добавить бронирование на уже прошедшее время." << endl;
                                     continue;
                                 }
-
-                                bool conflictDetected = false;
-                                int new_start_minutes = new_b.getStartTime().hour * 60 + new_b.getStartTime().minute;
-                                int new_end_minutes = new_b.getEndTime().hour * 60 + new_b.getEndTime().minute;
-
-                                for (const auto& existing_booking : bookingArray) {
-                                    if (existing_booking.getWorkstationId() == new_b.getWorkstationId() &&
-                                        existing_booking.getBookingDate() == new_b.getBookingDate()) {
-                                        int existing_start_minutes = existing_booking.getStartTime().hour * 60 +
-                                                                   existing_booking.getStartTime().minute;
-                                        int existing_end_minutes = existing_booking.getEndTime().hour * 60 +
-                                                                 existing_booking.getEndTime().minute;
-
-                                        if (new_start_minutes < existing_end_minutes &&
-                                            existing_start_minutes < new_end_minutes) {
-                                            conflictDetected = true;
-                                            cerr << "Ошибка: Конфликт времени! Станция " << new_b.getWorkstationId()
-                                                 << " уже забронирована в это время (ID существующей брони: "
-                                                 << existing_booking.getBookingId() << ")." << endl;
-                                            break;
-                                        }
-                                    }
-                                }
-
-                                if (conflictDetected) {
+                                if (result.error == EngineError::Conflict) {
+                                    printConflict("Ошибка: Конфликт времени!", workstationId, result.conflictingIds);
                                     continue;
                                 }
-
-                                manager.addBooking(new_b);
-                                bookingArray.push_back(new_b);
-
-                                bool status_updated = false;
-                                for (auto &ws : wsArray) {
-                                    if (ws.getId() == workstationId) {
-                                        if (ws.getStatus() != "booked") {
-                                            manager.updateWorkstationStatus(workstationId, "booked");
-                                            ws.updateStatus("booked");
-                                            status_updated = true;
-                                        }
-                                        break;
-                                    }
+                                if (!result.ok()) {
+                                    cout << "Ошибка: " << engineErrorName(result.error) << endl;
+                                    continue;
                                 }
 
                                 cout << "Бронирование добавлено."
-                                     << (status_updated ? " Статус станции обновлен на 'booked'." : "") << endl;
+                                     << (result.workstationBooked ? " Статус станции обновлен на 'booked'." : "") << endl;
                                 break;
                             }
                             case 3: {
@@ -480,56 +406,18 @@ void manageData(BookingManager &manager) {
                                 }
                                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-                                int wsId_of_deleted_booking = -1;
-                                size_t initial_size = bookingArray.size();
-
-                                bookingArray.erase(
-                                    remove_if(bookingArray.begin(), bookingArray.end(),
-                                        [&](const Booking& b){
-                                            if (b.getBookingId() == bookingId_to_delete) {
-                                                wsId_of_deleted_booking = b.getWorkstationId();
-                                                return true;
-                                            }
-                                            return false;
-                                        }
-                                    ),
-                                    bookingArray.end()
-                                );
-
-                                if (bookingArray.size() < initial_size) {
-                                    manager.deleteBooking(bookingId_to_delete);
-                                    cout << "Бронирование удалено." << endl;
-
-                                    bool other_active_bookings_exist = false;
-                                    if (wsId_of_deleted_booking != -1) {
-                                        auto checkTime = chrono::system_clock::now();
-                                        for(const auto& b : bookingArray) {
-                                            if (b.getWorkstationId() == wsId_of_deleted_booking) {
-                                                auto bookingEndTime = b.getEndDateTime();
-                                                if(bookingEndTime != chrono::system_clock::time_point::min() &&
-                                                   bookingEndTime >= checkTime) {
-                                                    other_active_bookings_exist = true;
-                                                    break;
-                                                }
-                                            }
-                                        }
-
-                                        if (!other_active_bookings_exist) {
-                                            for(auto& ws : wsArray) {
-                                                if(ws.getId() == wsId_of_deleted_booking &&
-                                                   ws.getStatus() == "booked") {
-                                                    manager.updateWorkstationStatus(wsId_of_deleted_booking, "available");
-                                                    ws.updateStatus("available");
-                                                    cout << "Статус станции " << wsId_of_deleted_booking
-                                                         << " изменен на 'available', так как других активных броней нет."
-                                                         << endl;
-                                                    break;
-                                                }
-                                            }
-                                        }
-                                    }
-                                } else {
+                                optional<Booking> deleted_b = engine.findBooking(bookingId_to_delete);
+                                EngineResult result = engine.cancelBooking(bookingId_to_delete);
+                                if (!result.ok()) {
                                     cout << "Бронирование с таким ID не найдено." << endl;
+                                    break;
+                                }
+
+                                cout << "Бронирование удалено." << endl;
+                                if (result.workstationReleased) {
+                                    cout << "Статус станции " << deleted_b->getWorkstationId()
+                                         << " изменен на 'available', так как других активных броней нет."
+                                         << endl;
                                 }
                                 break;
                             }
@@ -544,13 +432,7 @@ void manageData(BookingManager &manager) {
                                 }
                                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-                                Booking* booking_ptr = nullptr;
-                                for(auto& b : bookingArray) {
-                                    if(b.getBookingId() == bookingId_to_update) {
-                                        booking_ptr = &b;
-                                        break;
-                                    }
-                                }
+                                optional<Booking> booking_ptr = engine.findBooking(bookingId_to_update);
 
                                 if (!booking_ptr) {
                                     cout << "Бронирование с ID " << bookingId_to_update << " не найдено." << endl;
@@ -559,7 +441,7 @@ void manageData(BookingManager &manager) {
 
                                 int new_workstationId;
                                 string new_clientName, new_bookingDateStr, new_startTimeStr, new_endTimeStr;
-                                Time new_start, new_end;
+                                TimeOfDay new_start, new_end;
 
                                 cout << "Введите новый ID рабочей станции (текущий: "
                                      << booking_ptr->getWorkstationId() << "): ";
@@ -571,112 +453,85 @@ void manageData(BookingManager &manager) {
                                 }
                                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-                                bool new_ws_exists = false;
-                                for(const auto& ws : wsArray) {
-                                    if(ws.getId() == new_workstationId) {
-                                        new_ws_exists = true;
-                                        break;
-                                    }
-                                }
-
-                                if(!new_ws_exists) {
+                                if(!engine.findWorkstation(new_workstationId)) {
                                     cout << "Ошибка: Станция с ID " << new_workstationId << " не найдена.\n";
                                     continue;
                                 }
 
-                                cout << "Введите новое имя клиента (текущее: " << booking_ptr->getClientName()
+                                cout << "Введите новое имя клиента (текущее: " << engine.getClients().nameOf(booking_ptr->getClientId())
                                      << ", Enter чтобы оставить): ";
                                 getline(cin, new_clientName);
-                                if(new_clientName.empty()) {
-                                    new_clientName = booking_ptr->getClientName();
-                                }
 
-                                cout << "Введите новую дату (DD-MM-YYYY) (текущая: " << booking_ptr->getBookingDate()
+                                cout << "Введите новую дату (DD-MM-YYYY) (текущая: " << booking_ptr->getBookingDate().toString()
                                      << ", Enter чтобы оставить): ";
                                 getline(cin, new_bookingDateStr);
-                                if(new_bookingDateStr.empty()) {
-                                    new_bookingDateStr = booking_ptr->getBookingDate();
-                                } else if (!isValidDateFormat(new_bookingDateStr)) {
-                                    cout << "Ошибка: Неверный формат даты. Используйте DD-MM-YYYY." << endl;
+                                Date new_bookingDate = booking_ptr->getBookingDate();
+                                if (!new_bookingDateStr.empty() && !parseDate(new_bookingDateStr, new_bookingDate)) {
+                                    cout << "Ошибка: Неверная дата. Используйте DD-MM-YYYY (дата должна существовать)." << endl;
                                     continue;
                                 }
 
                                 cout << "Введите новое время начала (HH:MM) (текущее: " << setfill('0') << setw(2)
-                                     << booking_ptr->getStartTime().hour << ":" << setw(2)
-                                     << booking_ptr->getStartTime().minute << ", Enter чтобы оставить): ";
+                                     << booking_ptr->getStartTime().hour() << ":" << setw(2)
+                                     << booking_ptr->getStartTime().minute() << ", Enter чтобы оставить): ";
                                 getline(cin, new_startTimeStr);
                                 if(new_startTimeStr.empty()) {
                                     new_start = booking_ptr->getStartTime();
-                                } else if (!parseTimeHHMM(new_startTimeStr, new_start)) {
+                                } else if (!parseTime(new_startTimeStr, new_start)) {
                                     cout << "Ошибка: Неверный формат времени начала. Используйте HH:MM." << endl;
                                     continue;
                                 }
 
                                 cout << "Введите новое время окончания (HH:MM) (текущее: " << setfill('0') << setw(2)
-                                     << booking_ptr->getEndTime().hour << ":" << setw(2)
-                                     << booking_ptr->getEndTime().minute << ", Enter чтобы оставить): ";
+                                     << booking_ptr->getEndTime().hour() << ":" << setw(2)
+                                     << booking_ptr->getEndTime().minute() << ", Enter чтобы оставить): ";
                                 getline(cin, new_endTimeStr);
                                 if(new_endTimeStr.empty()) {
                                     new_end = booking_ptr->getEndTime();
-                                } else if (!parseTimeHHMM(new_endTimeStr, new_end)) {
+                                } else if (!parseTime(new_endTimeStr, new_end)) {
                                     cout << "Ошибка: Неверный формат времени окончания. Используйте HH:MM." << endl;
                                     continue;
                                 }
 
-                                if (new_start.hour * 60 + new_start.minute >= new_end.hour * 60 + new_end.minute) {
+                                if (new_start >= new_end) {
                                     cout << "Ошибка: Время начала должно быть раньше времени окончания.\n";
                                     continue;
                                 }
 
-                                Booking updated_b(bookingId_to_update, new_workstationId, new_clientName,
-                                                new_bookingDateStr, new_start, new_end);
-                                auto endTimePoint = updated_b.getEndDateTime();
-
-                                if (endTimePoint != chrono::system_clock::time_point::min() &&
-                                    endTimePoint < chrono::system_clock::now()) {
+                                EngineResult result = engine.updateBooking(BookingRequest{
+                                    bookingId_to_update, new_workstationId, new_clientName, new_bookingDate, new_start, new_end });
+                                if (result.error == EngineError::InPast) {
                                     cout << "Ошибка: Нельзя обновить бронирование на уже прошедшее время." << endl;
                                     continue;
                                 }
-
-                                bool conflictDetected = false;
-                                int new_start_minutes = updated_b.getStartTime().hour * 60 +
-                                                      updated_b.getStartTime().minute;
-                                int new_end_minutes = updated_b.getEndTime().hour * 60 +
-                                                    updated_b.getEndTime().minute;
-
-                                for (const auto& existing_booking : bookingArray) {
-                                    if (existing_booking.getBookingId() == updated_b.getBookingId()) {
-                                        continue;
-                                    }
-
-                                    if (existing_booking.getWorkstationId() == updated_b.getWorkstationId() &&
-                                        existing_booking.getBookingDate() == updated_b.getBookingDate()) {
-                                        int existing_start_minutes = existing_booking.getStartTime().hour * 60 +
-                                                                   existing_booking.getStartTime().minute;
-                                        int existing_end_minutes = existing_booking.getEndTime().hour * 60 +
-                                                                 existing_booking.getEndTime().minute;
-
-                                        if (new_start_minutes < existing_end_minutes &&
-                                            existing_start_minutes < new_end_minutes) {
-                                            conflictDetected = true;
-                                            cerr << "Ошибка: Конфликт времени при обновлении! Станция "
-                                                 << updated_b.getWorkstationId()
-                                                 << " уже забронирована в это время (ID существующей брони: "
-                                                 << existing_booking.getBookingId() << ")." << endl;
-                                            break;
-                                        }
-                                    }
+                                if (result.error == EngineError::Conflict) {
+                                    printConflict("Ошибка: Конфликт времени при обновлении!", new_workstationId, result.conflictingIds);
+                                    continue;
                                 }
-
-                                if (conflictDetected) {
+                                if (!result.ok()) {
+                                    cout << "Ошибка: " << engineErrorName(result.error) << endl;
                                     continue;
                                 }
-
-                                manager.updateBooking(bookingId_to_update, updated_b);
-                                *booking_ptr = updated_b;
                                 cout << "Бронирование обновлено." << endl;
                                 break;
                             }
+                            case 5: {
+                                string dayStr;
+                                cout << "Введите дату (формат DD-MM-YYYY): ";
+                                getline(cin, dayStr);
+                                Date day;
+                                if (!parseDate(dayStr, day)) {
+                                    cout << "Ошибка: Неверная дата. Используйте DD-MM-YYYY (дата должна существовать)." << endl;
+                                    continue;
+                                }
+
+                                vector<int> ids = engine.bookingsForDay(day);
+                                cout << "\n--- Бронирования на " << day.toString() << " (" << ids.size() << ") ---\n";
+                                for (int id : ids) {
+                                    engine.findBooking(id)->display(engine.getClients());
+                                }
+                                break;
+                            }
                             default:
                                 cout << "Неверный выбор. Попробуйте снова." << endl;
                         }
@@ -692,15 +547,62 @@ void manageData(BookingManager &manager) {
     }
 }
 
-int main() {
+// kpkapp --batch file.jsonl [--write-behind]: команды из файла ("-" —
+// стандартный ввод), результаты JSONL в stdout, итог — в stderr.
+int runBatchMode(const char* path, bool writeBehind) {
+    ifstream file;
+    if (strcmp(path, "-") != 0) {
+        file.open(path);
+        if (!file) {
+            cerr << "Не удалось открыть файл команд: " << path << endl;
+            return 1;
+        }
+    }
+    istream& in = file.is_open() ? static_cast<istream&>(file) : cin;
+
+    // Истечение — только командой purge_expired: повтор трафика не должен
+    // зависеть от того, когда его запустили.
+    EngineConfig config;
+    config.backgroundExpiry = false;
+    config.writeBehind = writeBehind;
+    BookingEngine engine(config);
+    BatchSummary summary = runBatch(engine, in, cout);
+
+    cerr << fixed << setprecision(3)
+         << "Команд: " << summary.commands << " за " << summary.seconds << " с ("
+         << setprecision(0) << summary.commandsPerSecond() << " команд/с), фиксаций: " << summary.commits << "\n"
+         << "Успешно: " << summary.succeeded << ", отклонено: " << summary.rejected
+         << ", не разобрано: " << summary.invalid << ", ошибок базы: " << summary.failed << endl;
+    return summary.invalid == 0 && summary.failed == 0 ? 0 : 2;
+}
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    // Консоль Windows по умолчанию не в UTF-8; терминалы Linux уже в нём.
     SetConsoleOutputCP(CP_UTF8);
+#endif
     cout.sync_with_stdio(false);
     cin.tie(nullptr);
 
-    unique_ptr<BookingManager> manager_ptr;
+    bool writeBehind = argc == 4 && strcmp(argv[3], "--write-behind") == 0;
+    if ((argc == 3 || writeBehind) && strcmp(argv[1], "--batch") == 0) {
+        try {
+            return runBatchMode(argv[2], writeBehind);
+        } catch (const exception &ex) {
+            cerr << "Критическая ошибка программы: " << ex.what() << endl;
+            return 1;
+        }
+    }
+    if (argc != 1) {
+        cerr << "Использование: kpkapp [--batch файл.jsonl [--write-behind]]" << endl;
+        return 1;
+    }
+
+    unique_ptr<BookingEngine> engine;
     try {
-        manager_ptr = make_unique<BookingManager>();
-        manageData(*manager_ptr);
+        engine = make_unique<BookingEngine>();
+        cout << "Данные успешно загружены из booking.db." << endl;
+        manageData(*engine);
     } catch (const exception &ex) {
         cerr << "Критическая ошибка программы: " << ex.what() << endl;
         return 1;
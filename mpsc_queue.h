@@ -0,0 +1,60 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+// Очередь без блокировок: много производителей, один потребитель (схема
+// Вьюкова). push из любого потока — один atomic exchange без ожидания,
+// pop и empty — только из потока-потребителя. Пока производитель находится
+// между exchange и записью next, его элемент ещё не виден потребителю:
+// empty() может вернуть true, поэтому ожидающий потребитель должен
+// проверять очередь повторно (см. ShardedEngine).
+template <typename T>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next{ nullptr };
+        std::optional<T> value;
+    };
+
+    alignas(64) std::atomic<Node*> head; // последний добавленный узел
+    alignas(64) Node* tail;              // заглушка перед первым элементом
+
+public:
+    MpscQueue() : head(new Node), tail(head.load(std::memory_order_relaxed)) {}
+    ~MpscQueue() {
+        T value;
+        while (pop(value)) {
+        }
+        delete tail;
+    }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node;
+        node->value.emplace(std::move(value));
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Элемент переносится в value, а не возвращается в optional: GCC на -O1
+    // ошибочно считает содержимое такого optional неинициализированным.
+    bool pop(T& value) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        value = std::move(*next->value);
+        next->value.reset();
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+    bool empty() const { return tail->next.load(std::memory_order_acquire) == nullptr; }
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,81 @@
+#include "occupancy_bitmap.h"
+#include <algorithm>
+#if defined(KPK_HAS_AVX2)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+static uint64_t wordMask(int word, int startMinute, int endMinute) {
+    int lo = max(startMinute - word * 64, 0);
+    int hi = min(endMinute - word * 64, 64);
+    if (lo >= hi) {
+        return 0;
+    }
+    uint64_t upper = hi == 64 ? ~0ULL : (1ULL << hi) - 1;
+    uint64_t lower = (1ULL << lo) - 1;
+    return upper & ~lower;
+}
+
+static void clampRange(int& startMinute, int& endMinute) {
+    startMinute = max(startMinute, 0);
+    endMinute = min(endMinute, kMinutesPerDay);
+}
+
+void setRange(DayBitmap& bitmap, int startMinute, int endMinute) {
+    clampRange(startMinute, endMinute);
+    for (int word = startMinute / 64; startMinute < endMinute && word <= (endMinute - 1) / 64; ++word) {
+        bitmap.words[word] |= wordMask(word, startMinute, endMinute);
+    }
+}
+
+void clearRange(DayBitmap& bitmap, int startMinute, int endMinute) {
+    clampRange(startMinute, endMinute);
+    for (int word = startMinute / 64; startMinute < endMinute && word <= (endMinute - 1) / 64; ++word) {
+        bitmap.words[word] &= ~wordMask(word, startMinute, endMinute);
+    }
+}
+
+bool anyInRange(const DayBitmap& bitmap, int startMinute, int endMinute) {
+    clampRange(startMinute, endMinute);
+    for (int word = startMinute / 64; startMinute < endMinute && word <= (endMinute - 1) / 64; ++word) {
+        if (bitmap.words[word] & wordMask(word, startMinute, endMinute)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+DayBitmap rangeMask(int startMinute, int endMinute) {
+    DayBitmap mask;
+    setRange(mask, startMinute, endMinute);
+    return mask;
+}
+
+bool intersectsScalar(const DayBitmap& bitmap, const DayBitmap& mask) {
+    uint64_t acc = 0;
+    for (int i = 0; i < kOccupancyWords; ++i) {
+        acc |= bitmap.words[i] & mask.words[i];
+    }
+    return acc != 0;
+}
+
+#if defined(KPK_HAS_AVX2)
+bool intersectsAvx2(const DayBitmap& bitmap, const DayBitmap& mask) {
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < kOccupancyWords; i += 4) {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(bitmap.words + i));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(mask.words + i));
+        acc = _mm256_or_si256(acc, _mm256_and_si256(a, b));
+    }
+    return !_mm256_testz_si256(acc, acc);
+}
+#endif
+
+bool intersects(const DayBitmap& bitmap, const DayBitmap& mask) {
+#if defined(KPK_HAS_AVX2)
+    return intersectsAvx2(bitmap, mask);
+#else
+    return intersectsScalar(bitmap, mask);
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef OCCUPANCY_BITMAP_H
+#define OCCUPANCY_BITMAP_H
+
+#include <cstdint>
+
+constexpr int kMinutesPerDay = 1440;
+// 1440 бит = 22.5 слова; округляем до 24 слов, то есть шести векторов AVX2 по 256 бит.
+constexpr int kOccupancyWords = 24;
+
+// Занятость станции за сутки: бит i установлен, если минута i занята бронью.
+struct alignas(32) DayBitmap {
+    std::uint64_t words[kOccupancyWords] = {};
+};
+
+void setRange(DayBitmap& bitmap, int startMinute, int endMinute);
+void clearRange(DayBitmap& bitmap, int startMinute, int endMinute);
+
+// Проверка одного интервала: трогает только слова, попадающие в [startMinute, endMinute).
+bool anyInRange(const DayBitmap& bitmap, int startMinute, int endMinute);
+
+// Маска интервала для массовых проверок: строится один раз и
+// накладывается на битовые карты всех станций.
+DayBitmap rangeMask(int startMinute, int endMinute);
+
+bool intersectsScalar(const DayBitmap& bitmap, const DayBitmap& mask);
+#if defined(__AVX2__)
+#define KPK_HAS_AVX2 1
+bool intersectsAvx2(const DayBitmap& bitmap, const DayBitmap& mask);
+#endif
+// Выбирает AVX2-ядро, если программа собрана с поддержкой AVX2 (KPK_ENABLE_AVX2).
+bool intersects(const DayBitmap& bitmap, const DayBitmap& mask);
+
+#endif // OCCUPANCY_BITMAP_H
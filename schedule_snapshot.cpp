@@ -0,0 +1,183 @@
+#include "schedule_snapshot.h"
+#include "booking.h"
+#include <algorithm>
+
+using namespace std;
+
+static bool startsBefore(const ScheduledBooking& b, Date day, TimeOfDay start) {
+    return b.day != day ? b.day < day : b.start < start;
+}
+
+bool StationSchedule::isFree(Date day, TimeOfDay start, TimeOfDay end) const {
+    // Брони одной станции за день обычно не пересекаются, но старые данные
+    // могут: поэтому проверяются все брони дня, начавшиеся до end.
+    auto first = lower_bound(bookings.begin(), bookings.end(), day,
+                             [](const ScheduledBooking& b, Date d) { return b.day < d; });
+    for (auto it = first; it != bookings.end() && it->day == day && it->start < end; ++it) {
+        if (start < it->end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ScheduleSnapshot::bookingCount() const {
+    size_t count = 0;
+    for (const StationSchedule* station : stations) {
+        count += station->bookings.size();
+    }
+    return count;
+}
+
+const StationSchedule* ScheduleSnapshot::find(int workstationId) const {
+    auto it = lower_bound(stations.begin(), stations.end(), workstationId,
+                          [](const StationSchedule* s, int id) { return s->id() < id; });
+    return it != stations.end() && (*it)->id() == workstationId ? *it : nullptr;
+}
+
+bool ScheduleSnapshot::isFree(int workstationId, Date day, TimeOfDay start, TimeOfDay end) const {
+    const StationSchedule* station = find(workstationId);
+    return station && station->isFree(day, start, end);
+}
+
+vector<int> ScheduleSnapshot::workstationsWithStatus(WorkstationStatus status) const {
+    vector<int> ids;
+    for (const StationSchedule* station : stations) {
+        if (baseOf(station->workstation).getStatus() == status) {
+            ids.push_back(station->id());
+        }
+    }
+    return ids;
+}
+
+vector<int> ScheduleSnapshot::bookingsForDay(Date day) const {
+    vector<int> ids;
+    for (const StationSchedule* station : stations) {
+        auto it = lower_bound(station->bookings.begin(), station->bookings.end(), day,
+                              [](const ScheduledBooking& b, Date d) { return b.day < d; });
+        for (; it != station->bookings.end() && it->day == day; ++it) {
+            ids.push_back(it->bookingId);
+        }
+    }
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+SchedulePublisher::SchedulePublisher() : current(new ScheduleSnapshot) {}
+
+SchedulePublisher::~SchedulePublisher() {
+    const ScheduleSnapshot* snapshot = current.load();
+    for (const StationSchedule* station : snapshot->stations) {
+        delete station;
+    }
+    delete snapshot;
+}
+
+SchedulePublisher::Reader SchedulePublisher::read() const {
+    EpochReclaimer::Guard guard = reclaimer.enter();
+    return Reader(std::move(guard), current.load());
+}
+
+StationSchedule* SchedulePublisher::draft(int workstationId) {
+    auto it = drafts.find(workstationId);
+    if (it != drafts.end()) {
+        return it->second.get();
+    }
+    const StationSchedule* station = published().find(workstationId);
+    if (!station) {
+        return nullptr;
+    }
+    auto copy = make_unique<StationSchedule>(*station);
+    StationSchedule* result = copy.get();
+    drafts.emplace(workstationId, std::move(copy));
+    return result;
+}
+
+void SchedulePublisher::reset() {
+    for (const StationSchedule* station : published().getStations()) {
+        drafts[station->id()].reset();
+    }
+    for (auto& entry : drafts) {
+        entry.second.reset();
+    }
+}
+
+void SchedulePublisher::putStation(const AnyWorkstation& ws) {
+    int id = workstationId(ws);
+    if (StationSchedule* station = draft(id)) {
+        station->workstation = ws;
+    } else {
+        drafts[id] = make_unique<StationSchedule>(StationSchedule{ ws, {} });
+    }
+}
+
+void SchedulePublisher::removeStation(int workstationId) {
+    drafts[workstationId].reset();
+}
+
+void SchedulePublisher::setStatus(int workstationId, WorkstationStatus status) {
+    if (StationSchedule* station = draft(workstationId)) {
+        // Тот же переход, что движок уже проверил и применил к своей станции.
+        baseOf(station->workstation).updateStatus(status);
+    }
+}
+
+void SchedulePublisher::addBooking(const Booking& b) {
+    StationSchedule* station = draft(b.getWorkstationId());
+    if (!station) {
+        return;
+    }
+    ScheduledBooking entry{ b.getBookingId(), b.getClientId(), b.getBookingDate(), b.getStartTime(), b.getEndTime() };
+    auto it = upper_bound(station->bookings.begin(), station->bookings.end(), entry,
+                          [](const ScheduledBooking& a, const ScheduledBooking& x) { return startsBefore(a, x.day, x.start); });
+    station->bookings.insert(it, entry);
+}
+
+void SchedulePublisher::removeBooking(int workstationId, int bookingId) {
+    if (StationSchedule* station = draft(workstationId)) {
+        auto& bookings = station->bookings;
+        bookings.erase(remove_if(bookings.begin(), bookings.end(),
+                                 [&](const ScheduledBooking& b) { return b.bookingId == bookingId; }),
+                       bookings.end());
+    }
+}
+
+void SchedulePublisher::publish() {
+    if (drafts.empty()) {
+        return;
+    }
+    const ScheduleSnapshot& old = published();
+    vector<int> changedIds;
+    changedIds.reserve(drafts.size());
+    for (const auto& entry : drafts) {
+        changedIds.push_back(entry.first);
+    }
+    sort(changedIds.begin(), changedIds.end());
+
+    // Слияние по ID: неизменённые станции переходят в новую версию как есть.
+    auto next = make_unique<ScheduleSnapshot>();
+    next->version = old.version + 1;
+    next->stations.reserve(old.stations.size() + changedIds.size());
+    vector<const StationSchedule*> replaced;
+    size_t i = 0;
+    for (int id : changedIds) {
+        while (i < old.stations.size() && old.stations[i]->id() < id) {
+            next->stations.push_back(old.stations[i++]);
+        }
+        if (i < old.stations.size() && old.stations[i]->id() == id) {
+            replaced.push_back(old.stations[i++]);
+        }
+        if (unique_ptr<StationSchedule>& station = drafts[id]) {
+            next->stations.push_back(station.release());
+        }
+    }
+    next->stations.insert(next->stations.end(), old.stations.begin() + static_cast<ptrdiff_t>(i), old.stations.end());
+    drafts.clear();
+
+    const ScheduleSnapshot* previous = current.exchange(next.release());
+    reclaimer.retire(previous);
+    for (const StationSchedule* station : replaced) {
+        reclaimer.retire(station);
+    }
+    reclaimer.reclaim();
+}
@@ -0,0 +1,109 @@
+#ifndef SCHEDULE_SNAPSHOT_H
+#define SCHEDULE_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "civil_date.h"
+#include "epoch_reclaimer.h"
+#include "Time.h"
+#include "workstation.h"
+
+class Booking;
+
+struct ScheduledBooking {
+    int bookingId;
+    int clientId;
+    Date day;
+    TimeOfDay start;
+    TimeOfDay end;
+};
+
+// Неизменяемое расписание одной станции: сама станция и её брони по (день, начало).
+struct StationSchedule {
+    AnyWorkstation workstation;
+    std::vector<ScheduledBooking> bookings;
+
+    int id() const { return workstationId(workstation); }
+    bool isFree(Date day, TimeOfDay start, TimeOfDay end) const;
+};
+
+// Неизменяемая версия расписания: станции по возрастанию ID. Расписания
+// станций, не изменившихся между версиями, общие для этих версий.
+class ScheduleSnapshot {
+private:
+    std::uint64_t version = 0;
+    std::vector<const StationSchedule*> stations;
+
+    friend class SchedulePublisher;
+
+public:
+    std::uint64_t getVersion() const { return version; }
+    const std::vector<const StationSchedule*>& getStations() const { return stations; }
+    std::size_t bookingCount() const;
+
+    const StationSchedule* find(int workstationId) const;
+    // false, если станции нет.
+    bool isFree(int workstationId, Date day, TimeOfDay start, TimeOfDay end) const;
+    // ID по возрастанию.
+    std::vector<int> workstationsWithStatus(WorkstationStatus status) const;
+    std::vector<int> bookingsForDay(Date day) const;
+};
+
+// Публикация версий расписания для читателей из других потоков (RCU).
+// Писатель — один поток (поток движка): изменения копируют только
+// расписания затронутых станций, publish() собирает из них новую версию
+// и подменяет её одним атомарным указателем. Читатель через read()
+// получает целостную версию без блокировок; старые версии и расписания
+// станций удаляются по эпохам (EpochReclaimer), когда их уже никто не читает.
+class SchedulePublisher {
+private:
+    std::atomic<const ScheduleSnapshot*> current;
+    mutable EpochReclaimer reclaimer;
+    // Черновики изменённых станций; nullptr — станция удалена.
+    std::unordered_map<int, std::unique_ptr<StationSchedule>> drafts;
+
+    const ScheduleSnapshot& published() const { return *current.load(std::memory_order_relaxed); }
+    // Черновик станции (копия опубликованного расписания); nullptr, если станции нет.
+    StationSchedule* draft(int workstationId);
+
+public:
+    class Reader {
+    private:
+        EpochReclaimer::Guard guard;
+        const ScheduleSnapshot* snapshot;
+
+    public:
+        Reader(EpochReclaimer::Guard&& _guard, const ScheduleSnapshot* _snapshot)
+            : guard(std::move(_guard)), snapshot(_snapshot) {}
+
+        const ScheduleSnapshot& operator*() const { return *snapshot; }
+        const ScheduleSnapshot* operator->() const { return snapshot; }
+    };
+
+    SchedulePublisher();
+    ~SchedulePublisher();
+    SchedulePublisher(const SchedulePublisher&) = delete;
+    SchedulePublisher& operator=(const SchedulePublisher&) = delete;
+
+    // Из любого потока. Пока Reader жив, его версия не удаляется.
+    Reader read() const;
+
+    // Писатель: изменения копятся до publish().
+    void reset(); // удалить все станции (перед полной загрузкой)
+    void putStation(const AnyWorkstation& ws); // добавить или заменить станцию, брони сохраняются
+    void removeStation(int workstationId);
+    void setStatus(int workstationId, WorkstationStatus status);
+    void addBooking(const Booking& b);
+    void removeBooking(int workstationId, int bookingId);
+    // Публикует накопленные изменения новой версией; без изменений ничего не делает.
+    void publish();
+
+    std::uint64_t version() const { return published().getVersion(); }
+    std::size_t pendingReclaim() const { return reclaimer.pending(); }
+};
+
+#endif // SCHEDULE_SNAPSHOT_H
@@ -0,0 +1,123 @@
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "booking_engine.h"
+#include "booking_server.h"
+#include "sharded_engine.h"
+
+using namespace std;
+
+static BookingServer* runningServer = nullptr;
+
+static void onSignal(int) {
+    if (runningServer) {
+        runningServer->stop();
+    }
+}
+
+static void printUsage() {
+    cerr << "Использование: kpkserver [--host адрес] [--port N] [--no-tcp] [--unix путь] [--write-behind]"
+            " [--shards N [--shard-files]]" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    ServerConfig config;
+    EngineConfig engineConfig;
+    ShardedEngineConfig shardedConfig;
+    shardedConfig.shards = 0;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--host") == 0 && hasValue) {
+            config.tcpHost = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && hasValue) {
+            char* end = nullptr;
+            long port = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || port < 0 || port > 65535) {
+                printUsage();
+                return 1;
+            }
+            config.tcpPort = static_cast<uint16_t>(port);
+        } else if (strcmp(argv[i], "--no-tcp") == 0) {
+            config.listenTcp = false;
+        } else if (strcmp(argv[i], "--unix") == 0 && hasValue) {
+            config.unixPath = argv[++i];
+        } else if (strcmp(argv[i], "--write-behind") == 0) {
+            engineConfig.writeBehind = true;
+        } else if (strcmp(argv[i], "--shards") == 0 && hasValue) {
+            char* end = nullptr;
+            long shards = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || shards < 1 || shards > 256) {
+                printUsage();
+                return 1;
+            }
+            shardedConfig.shards = static_cast<unsigned>(shards);
+        } else if (strcmp(argv[i], "--shard-files") == 0) {
+            shardedConfig.storagePerShard = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (!config.listenTcp && config.unixPath.empty()) {
+        cerr << "Не задан ни TCP-порт, ни Unix-сокет." << endl;
+        return 1;
+    }
+    if (shardedConfig.shards > 0 && engineConfig.writeBehind) {
+        cerr << "--write-behind и --shards несовместимы: разделы сами фиксируют изменения пачками." << endl;
+        return 1;
+    }
+    if (shardedConfig.storagePerShard && shardedConfig.shards == 0) {
+        printUsage();
+        return 1;
+    }
+
+    try {
+        // С --shards движок разделён по станциям, у раздела свой поток.
+        unique_ptr<BookingEngine> engine;
+        unique_ptr<ShardedEngine> shardedEngine;
+        unique_ptr<BookingServer> created;
+        if (shardedConfig.shards > 0) {
+            shardedConfig.engine = engineConfig;
+            shardedEngine = make_unique<ShardedEngine>(shardedConfig);
+            created = make_unique<BookingServer>(*shardedEngine, config);
+        } else {
+            engine = make_unique<BookingEngine>(engineConfig);
+            created = make_unique<BookingServer>(*engine, config);
+        }
+        BookingServer& server = *created;
+        if (config.listenTcp) {
+            cerr << "Сервер слушает " << config.tcpHost << ":" << server.tcpPort() << endl;
+        }
+        if (!config.unixPath.empty()) {
+            cerr << "Сервер слушает " << config.unixPath << endl;
+        }
+
+        runningServer = &server;
+        struct sigaction action {};
+        action.sa_handler = onSignal;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+        server.run();
+        runningServer = nullptr;
+
+        const BatchSummary& summary = server.getSummary();
+        cerr << "Запросов: " << summary.commands;
+        // Разделы фиксируют свои пачки сами, сервер их не считает.
+        if (!shardedEngine) {
+            cerr << ", фиксаций: " << summary.commits;
+        }
+        cerr << ", успешно: " << summary.succeeded << ", отклонено: " << summary.rejected
+             << ", не разобрано: " << summary.invalid << ", ошибок базы: " << summary.failed << endl;
+    } catch (const exception& ex) {
+        runningServer = nullptr;
+        cerr << "Критическая ошибка сервера: " << ex.what() << endl;
+        return 1;
+    }
+    return 0;
+}
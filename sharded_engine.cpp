@@ -0,0 +1,560 @@
+#include "sharded_engine.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+bool BookingLocator::claim(int bookingId, unsigned shard) {
+    Stripe& stripe = stripeFor(bookingId);
+    lock_guard<mutex> lock(stripe.mutex);
+    return stripe.shards.emplace(bookingId, shard).second;
+}
+
+bool BookingLocator::find(int bookingId, unsigned& shard) {
+    Stripe& stripe = stripeFor(bookingId);
+    lock_guard<mutex> lock(stripe.mutex);
+    auto it = stripe.shards.find(bookingId);
+    if (it == stripe.shards.end()) {
+        return false;
+    }
+    shard = it->second;
+    return true;
+}
+
+void BookingLocator::move(int bookingId, unsigned shard) {
+    Stripe& stripe = stripeFor(bookingId);
+    lock_guard<mutex> lock(stripe.mutex);
+    stripe.shards[bookingId] = shard;
+}
+
+void BookingLocator::release(int bookingId) {
+    Stripe& stripe = stripeFor(bookingId);
+    lock_guard<mutex> lock(stripe.mutex);
+    stripe.shards.erase(bookingId);
+}
+
+void BookingLocator::releaseShard(unsigned shard) {
+    for (Stripe& stripe : stripes) {
+        lock_guard<mutex> lock(stripe.mutex);
+        for (auto it = stripe.shards.begin(); it != stripe.shards.end();) {
+            it = it->second == shard ? stripe.shards.erase(it) : next(it);
+        }
+    }
+}
+
+// Барьер раздела: сообщает координатору, что поток раздела остановился, и
+// ждёт, пока его отпустят.
+class ParkTask : public ShardTask {
+private:
+    promise<void> parked;
+    shared_future<void> released;
+
+public:
+    explicit ParkTask(shared_future<void> _released) : released(std::move(_released)) {}
+
+    future<void> getParked() { return parked.get_future(); }
+
+    bool isBarrier() const override { return true; }
+    void wait() override {
+        parked.set_value();
+        released.wait();
+    }
+    void execute(BookingEngine&) override {}
+    void complete() override {}
+    void fail(exception_ptr) override {}
+};
+
+// Разделы, остановленные для операции координатора. Разделы
+// останавливаются строго по возрастанию номеров, и следующий — только
+// после того, как встал предыдущий: два координатора не могут ждать друг
+// друга по кругу. Деструктор отпускает все разделы.
+class ShardedEngine::ParkedShards {
+private:
+    ShardedEngine& owner;
+    promise<void> release;
+
+public:
+    ParkedShards(ShardedEngine& _owner, vector<unsigned> wanted) : owner(_owner) {
+        sort(wanted.begin(), wanted.end());
+        wanted.erase(unique(wanted.begin(), wanted.end()), wanted.end());
+        shared_future<void> released = release.get_future().share();
+        try {
+            for (unsigned index : wanted) {
+                auto task = make_unique<ParkTask>(released);
+                future<void> parked = task->getParked();
+                owner.post(*owner.shards[index], std::move(task));
+                parked.wait();
+            }
+        } catch (...) {
+            release.set_value();
+            throw;
+        }
+    }
+    ~ParkedShards() { release.set_value(); }
+    ParkedShards(const ParkedShards&) = delete;
+    ParkedShards& operator=(const ParkedShards&) = delete;
+
+    BookingEngine& engine(unsigned index) {
+        Shard& shard = *owner.shards[index];
+        if (!shard.engine) {
+            rethrow_exception(shard.broken);
+        }
+        return *shard.engine;
+    }
+};
+
+ShardedEngine::ShardedEngine(const ShardedEngineConfig& _config) : config(_config) {
+    config.shards = max(config.shards, 1u);
+    config.commitEvery = max<size_t>(config.commitEvery, 1);
+    shards.reserve(config.shards);
+    for (unsigned index = 0; index < config.shards; ++index) {
+        auto shard = make_unique<Shard>();
+        shard->index = index;
+        shard->engine = make_unique<BookingEngine>(shardConfig(*shard));
+        registerBookings(*shard);
+        shards.push_back(std::move(shard));
+    }
+    for (auto& shard : shards) {
+        Shard* owned = shard.get();
+        shard->worker = thread([this, owned] { run(*owned); });
+    }
+}
+
+ShardedEngine::~ShardedEngine() {
+    stopping.store(true);
+    for (auto& shard : shards) {
+        {
+            lock_guard<mutex> lock(shard->sleepMutex);
+            shard->wake.notify_one();
+        }
+        shard->worker.join();
+    }
+}
+
+EngineConfig ShardedEngine::shardConfig(const Shard& shard) const {
+    EngineConfig engineConfig = config.engine;
+    engineConfig.shardCount = config.shards;
+    engineConfig.shardIndex = shard.index;
+    engineConfig.schedule = shard.schedule;
+    if (config.storagePerShard) {
+        engineConfig.storage.path += "." + to_string(shard.index);
+    }
+    // Раздел сам фиксирует пачки своих задач (см. run()).
+    engineConfig.writeBehind = false;
+    return engineConfig;
+}
+
+void ShardedEngine::registerBookings(Shard& shard) {
+    const BookingStore& bookings = shard.engine->getBookings();
+    for (size_t row = 0; row < bookings.size(); ++row) {
+        locator.claim(bookings.rowAt(row).getBookingId(), shard.index);
+    }
+}
+
+// Движок раздела после неудачного COMMIT уже не совпадает с базой:
+// он загружается заново.
+void ShardedEngine::reload(Shard& shard) {
+    locator.releaseShard(shard.index);
+    shard.engine.reset();
+    try {
+        shard.engine = make_unique<BookingEngine>(shardConfig(shard));
+        registerBookings(shard);
+        shard.broken = nullptr;
+    } catch (...) {
+        shard.engine.reset();
+        shard.broken = current_exception();
+    }
+}
+
+// Брони, истёкшие в фоне, убираются из памяти и из locator. Если это
+// сорвалось на полпути, память раздела могла разойтись с базой.
+void ShardedEngine::collectExpired(Shard& shard) {
+    try {
+        releaseExpired(shard.engine->collectExpired());
+    } catch (...) {
+        reload(shard);
+    }
+}
+
+void ShardedEngine::releaseExpired(const vector<PurgeResult>& purged) {
+    for (const PurgeResult& result : purged) {
+        for (int bookingId : result.bookingIds) {
+            locator.release(bookingId);
+        }
+    }
+}
+
+void ShardedEngine::post(Shard& shard, unique_ptr<ShardTask> task) {
+    shard.inbox.push(std::move(task));
+    // Пара к барьеру в sleep(): либо поток раздела увидит задачу, либо мы — флаг sleeping.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (shard.sleeping.load(memory_order_relaxed)) {
+        lock_guard<mutex> lock(shard.sleepMutex);
+        shard.wake.notify_one();
+    }
+}
+
+void ShardedEngine::sleep(Shard& shard) {
+    shard.sleeping.store(true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    unique_lock<mutex> lock(shard.sleepMutex);
+    shard.wake.wait_for(lock, config.expiryPoll, [&] { return !shard.inbox.empty() || stopping.load(); });
+    shard.sleeping.store(false, memory_order_relaxed);
+}
+
+void ShardedEngine::run(Shard& shard) {
+    vector<unique_ptr<ShardTask>> batch;
+    unique_ptr<UnitOfWork> work;
+    // Пачка не зафиксирована: её задачи получают ошибку, движок раздела
+    // загружается заново.
+    auto failBatch = [&](exception_ptr error) {
+        work.reset();
+        for (auto& task : batch) {
+            task->fail(error);
+        }
+        batch.clear();
+        reload(shard);
+    };
+    auto commitBatch = [&] {
+        if (!work) {
+            return;
+        }
+        try {
+            work->commit();
+        } catch (...) {
+            failBatch(current_exception());
+            return;
+        }
+        work.reset();
+        for (auto& task : batch) {
+            task->complete();
+        }
+        batch.clear();
+    };
+
+    unique_ptr<ShardTask> task;
+    for (;;) {
+        if (!shard.inbox.pop(task)) {
+            commitBatch();
+            if (stopping.load()) {
+                return;
+            }
+            sleep(shard);
+            if (shard.engine) {
+                collectExpired(shard);
+            }
+            continue;
+        }
+        if (task->isBarrier()) {
+            commitBatch();
+            task->wait();
+            continue;
+        }
+        if (!work) {
+            if (shard.engine) {
+                collectExpired(shard);
+            }
+            if (!shard.engine) {
+                reload(shard);
+            }
+            if (!shard.engine) {
+                task->fail(shard.broken);
+                continue;
+            }
+            // BEGIN IMMEDIATE ждёт чужую запись не дольше busyTimeoutMs. Если
+            // транзакция не открылась, задача получает ошибку, а следующая
+            // задача пробует открыть транзакцию снова.
+            try {
+                work = make_unique<UnitOfWork>(shard.engine->getManager());
+            } catch (...) {
+                task->fail(current_exception());
+                continue;
+            }
+        }
+        task->execute(*shard.engine);
+        batch.push_back(std::move(task));
+        if (!shard.engine->getManager().inTransaction()) {
+            // SQLite откатил пачку сам (SQLITE_FULL, IOERR, NOMEM): без
+            // транзакции точки сохранения следующих задач фиксировались бы
+            // по одной, а их клиенты получили бы ошибку COMMIT.
+            failBatch(make_exception_ptr(runtime_error("Пачка задач раздела отменена: транзакция откатилась")));
+            continue;
+        }
+        if (batch.size() >= config.commitEvery) {
+            commitBatch();
+        }
+    }
+}
+
+future<EngineResult> ShardedEngine::addWorkstation(const AnyWorkstation& ws) {
+    return submit(shardFor(workstationId(ws)), [ws](BookingEngine& engine) { return engine.addWorkstation(ws); });
+}
+
+future<EngineResult> ShardedEngine::deleteWorkstation(int id) {
+    return submit(shardFor(id), [this, id](BookingEngine& engine) {
+        vector<int> bookingIds = engine.getBookings().idsForWorkstation(id);
+        EngineResult result = engine.deleteWorkstation(id);
+        if (result.ok()) {
+            for (int bookingId : bookingIds) {
+                locator.release(bookingId);
+            }
+        }
+        return result;
+    });
+}
+
+future<EngineResult> ShardedEngine::setWorkstationStatus(int id, WorkstationStatus newStatus) {
+    return submit(shardFor(id), [id, newStatus](BookingEngine& engine) { return engine.setWorkstationStatus(id, newStatus); });
+}
+
+future<EngineResult> ShardedEngine::addBooking(const BookingRequest& request) {
+    unsigned shard = shardFor(request.workstationId);
+    return submit(shard, [this, request, shard](BookingEngine& engine) {
+        EngineResult result;
+        if (!locator.claim(request.bookingId, shard)) {
+            result.error = EngineError::DuplicateBooking;
+            return result;
+        }
+        try {
+            result = engine.addBooking(request);
+        } catch (...) {
+            locator.release(request.bookingId);
+            throw;
+        }
+        if (!result.ok()) {
+            locator.release(request.bookingId);
+        }
+        return result;
+    });
+}
+
+future<EngineResult> ShardedEngine::updateBooking(const BookingRequest& request) {
+    unsigned from;
+    if (!locator.find(request.bookingId, from)) {
+        EngineResult result;
+        result.error = EngineError::BookingNotFound;
+        return ready(result);
+    }
+    unsigned to = shardFor(request.workstationId);
+    if (from == to) {
+        return submit(from, [request](BookingEngine& engine) { return engine.updateBooking(request); });
+    }
+    promise<EngineResult> moved;
+    try {
+        moved.set_value(moveBooking(request, from, to));
+    } catch (...) {
+        moved.set_exception(current_exception());
+    }
+    return moved.get_future();
+}
+
+// Перенос брони на станцию другого раздела: бронь проверяется в целевом
+// разделе, снимается в исходном и добавляется в целевой. Если добавить не
+// удалось, бронь возвращается в исходный раздел; если не удалось и это,
+// бронь потеряна: она убирается из locator, а вызывающий получает исключение.
+EngineResult ShardedEngine::moveBooking(const BookingRequest& request, unsigned from, unsigned to) {
+    ParkedShards parked(*this, { from, to });
+    BookingEngine& source = parked.engine(from);
+    BookingEngine& target = parked.engine(to);
+
+    EngineResult result;
+    optional<Booking> existing = source.findBooking(request.bookingId);
+    if (!existing) {
+        result.error = EngineError::BookingNotFound;
+        return result;
+    }
+    const string& clientName = source.getClients().nameOf(existing->getClientId());
+    BookingRequest original{ existing->getBookingId(), existing->getWorkstationId(), clientName,
+                             existing->getBookingDate(), existing->getStartTime(), existing->getEndTime() };
+    BookingRequest moved = request;
+    if (moved.clientName.empty()) {
+        moved.clientName = clientName;
+    }
+    result = target.checkBooking(moved);
+    if (!result.ok()) {
+        return result;
+    }
+
+    EngineResult cancelled = source.cancelBooking(request.bookingId);
+    if (!cancelled.ok()) {
+        return cancelled;
+    }
+    auto restore = [&] {
+        bool restored = false;
+        try {
+            restored = source.addBooking(original).ok();
+        } catch (...) {
+        }
+        if (!restored) {
+            locator.release(request.bookingId);
+            throw runtime_error("Бронь " + to_string(request.bookingId) +
+                                " потеряна при переносе: её не удалось ни добавить на станцию " +
+                                to_string(request.workstationId) + ", ни вернуть на станцию " +
+                                to_string(original.workstationId));
+        }
+    };
+    try {
+        result = target.addBooking(moved);
+    } catch (...) {
+        restore();
+        throw;
+    }
+    if (!result.ok()) {
+        restore();
+        return result;
+    }
+    locator.move(request.bookingId, to);
+    result.workstationReleased = cancelled.workstationReleased;
+    return result;
+}
+
+future<EngineResult> ShardedEngine::cancelBooking(int bookingId) {
+    unsigned shard;
+    if (!locator.find(bookingId, shard)) {
+        EngineResult result;
+        result.error = EngineError::BookingNotFound;
+        return ready(result);
+    }
+    return submit(shard, [this, bookingId](BookingEngine& engine) {
+        EngineResult result = engine.cancelBooking(bookingId);
+        if (result.ok()) {
+            locator.release(bookingId);
+        }
+        return result;
+    });
+}
+
+EngineResult ShardedEngine::addGroupBooking(const vector<BookingRequest>& requests) {
+    vector<unsigned> involved;
+    involved.reserve(requests.size());
+    for (const BookingRequest& request : requests) {
+        involved.push_back(shardFor(request.workstationId));
+    }
+    ParkedShards parked(*this, involved);
+
+    vector<const BookingRequest*> added;
+    auto rollback = [&] {
+        for (auto it = added.rbegin(); it != added.rend(); ++it) {
+            const BookingRequest& request = **it;
+            // Компенсация по возможности: вызывающему важнее исходная ошибка.
+            try {
+                if (parked.engine(shardFor(request.workstationId)).cancelBooking(request.bookingId).ok()) {
+                    locator.release(request.bookingId);
+                }
+            } catch (...) {
+            }
+        }
+    };
+
+    EngineResult total;
+    try {
+        for (const BookingRequest& request : requests) {
+            unsigned shard = shardFor(request.workstationId);
+            EngineResult result;
+            if (!locator.claim(request.bookingId, shard)) {
+                result.error = EngineError::DuplicateBooking;
+            } else {
+                try {
+                    result = parked.engine(shard).addBooking(request);
+                } catch (...) {
+                    locator.release(request.bookingId);
+                    throw;
+                }
+                if (!result.ok()) {
+                    locator.release(request.bookingId);
+                }
+            }
+            if (!result.ok()) {
+                rollback();
+                return result;
+            }
+            total.workstationBooked = total.workstationBooked || result.workstationBooked;
+            added.push_back(&request);
+        }
+    } catch (...) {
+        rollback();
+        throw;
+    }
+    return total;
+}
+
+future<optional<Booking>> ShardedEngine::findBooking(int bookingId) {
+    unsigned shard;
+    if (!locator.find(bookingId, shard)) {
+        return ready(optional<Booking>());
+    }
+    return submit(shard, [bookingId](BookingEngine& engine) { return engine.findBooking(bookingId); });
+}
+
+bool ShardedEngine::isFree(int workstationId, Date day, TimeOfDay start, TimeOfDay end) const {
+    return readSchedule(shardFor(workstationId))->isFree(workstationId, day, start, end);
+}
+
+vector<int> ShardedEngine::workstationIds() const {
+    vector<int> result;
+    for (unsigned shard = 0; shard < shardCount(); ++shard) {
+        for (const StationSchedule* station : readSchedule(shard)->getStations()) {
+            result.push_back(station->id());
+        }
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+vector<int> ShardedEngine::workstationsWithStatus(WorkstationStatus status) const {
+    vector<int> result;
+    for (unsigned shard = 0; shard < shardCount(); ++shard) {
+        vector<int> ids = readSchedule(shard)->workstationsWithStatus(status);
+        result.insert(result.end(), ids.begin(), ids.end());
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+vector<int> ShardedEngine::bookingsForDay(Date day) const {
+    vector<int> result;
+    for (unsigned shard = 0; shard < shardCount(); ++shard) {
+        vector<int> ids = readSchedule(shard)->bookingsForDay(day);
+        result.insert(result.end(), ids.begin(), ids.end());
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+vector<int> ShardedEngine::freeWorkstations(Date day, TimeOfDay start, TimeOfDay end) const {
+    vector<int> result;
+    for (unsigned shard = 0; shard < shardCount(); ++shard) {
+        SchedulePublisher::Reader snapshot = readSchedule(shard);
+        for (const StationSchedule* station : snapshot->getStations()) {
+            if (station->isFree(day, start, end)) {
+                result.push_back(station->id());
+            }
+        }
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+PurgeResult ShardedEngine::purgeExpired(chrono::system_clock::time_point now) {
+    vector<future<PurgeResult>> parts;
+    for (unsigned shard = 0; shard < shardCount(); ++shard) {
+        parts.push_back(submit(shard, [this, now](BookingEngine& engine) {
+            PurgeResult purged = engine.purgeExpired(now);
+            for (int bookingId : purged.bookingIds) {
+                locator.release(bookingId);
+            }
+            return purged;
+        }));
+    }
+    PurgeResult result;
+    for (auto& part : parts) {
+        PurgeResult purged = part.get();
+        result.bookingIds.insert(result.bookingIds.end(), purged.bookingIds.begin(), purged.bookingIds.end());
+        result.workstationIds.insert(result.workstationIds.end(), purged.workstationIds.begin(), purged.workstationIds.end());
+        result.releasedWorkstationIds.insert(result.releasedWorkstationIds.end(), purged.releasedWorkstationIds.begin(),
+                                             purged.releasedWorkstationIds.end());
+    }
+    return result;
+}
@@ -0,0 +1,219 @@
+#ifndef SHARDED_ENGINE_H
+#define SHARDED_ENGINE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "booking_engine.h"
+#include "mpsc_queue.h"
+
+struct ShardedEngineConfig {
+    // storage и backgroundExpiry — для каждого раздела; shardCount/shardIndex задаются здесь.
+    EngineConfig engine;
+    unsigned shards = 4;
+    // Своя база у каждого раздела: engine.storage.path + ".<номер раздела>".
+    // В общей базе (false) пачки разделов фиксируются по очереди: у SQLite
+    // один писатель на базу. Число разделов у готовых баз менять нельзя —
+    // станции чужих разделов движок не загружает.
+    bool storagePerShard = false;
+    // Задач раздела в одной транзакции: результаты отдаются после её COMMIT.
+    std::size_t commitEvery = 256;
+    // Как часто простаивающий раздел забирает брони, истёкшие в фоне.
+    std::chrono::milliseconds expiryPoll{ 1000 };
+};
+
+// ID брони -> номер раздела. Разделён на полосы со своими мьютексами:
+// операции с разными бронями почти никогда не ждут друг друга.
+class BookingLocator {
+private:
+    struct Stripe {
+        std::mutex mutex;
+        std::unordered_map<int, unsigned> shards;
+    };
+    std::array<Stripe, 64> stripes;
+
+    Stripe& stripeFor(int bookingId) { return stripes[static_cast<unsigned>(bookingId) % stripes.size()]; }
+
+public:
+    // false, если ID уже занят (в этом или другом разделе).
+    bool claim(int bookingId, unsigned shard);
+    bool find(int bookingId, unsigned& shard);
+    void move(int bookingId, unsigned shard);
+    void release(int bookingId);
+    void releaseShard(unsigned shard);
+};
+
+// Задача во входящей очереди раздела. execute выполняется потоком раздела
+// внутри открытой транзакции, complete — после её COMMIT, fail — если
+// COMMIT не удался.
+class ShardTask {
+public:
+    virtual ~ShardTask() = default;
+    // Барьер (см. ShardedEngine): поток раздела фиксирует открытую пачку,
+    // вызывает wait() и стоит в нём, пока раздел не отпустят.
+    virtual bool isBarrier() const { return false; }
+    virtual void wait() {}
+    virtual void execute(BookingEngine& engine) = 0;
+    virtual void complete() = 0;
+    virtual void fail(std::exception_ptr error) = 0;
+};
+
+template <typename R>
+class FunctionShardTask : public ShardTask {
+private:
+    std::function<R(BookingEngine&)> body;
+    std::promise<R> done;
+    std::optional<R> result;
+    std::exception_ptr error;
+
+public:
+    explicit FunctionShardTask(std::function<R(BookingEngine&)> _body) : body(std::move(_body)) {}
+
+    std::future<R> getFuture() { return done.get_future(); }
+
+    void execute(BookingEngine& engine) override {
+        try {
+            result.emplace(body(engine));
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+    void complete() override {
+        if (error) {
+            done.set_exception(error);
+        } else {
+            done.set_value(std::move(*result));
+        }
+    }
+    void fail(std::exception_ptr commitError) override { done.set_exception(error ? error : commitError); }
+};
+
+// Движок, разделённый по ID станции на N разделов: shardOf(id, N). Каждым
+// разделом (BookingEngine со своим соединением с базой) владеет один поток;
+// задачи приходят во входящую очередь без блокировок (MpscQueue) и
+// фиксируются пачками по commitEvery. Операции над одной станцией идут в
+// её раздел и не ждут остальных разделов.
+//
+// С общей базой разделы параллельно проверяют и применяют изменения в
+// памяти, но запись в базу у них одна: раздел держит блокировку записи WAL
+// на всю пачку, остальные ждут её COMMIT. Чтобы запись росла с числом
+// разделов, нужен storagePerShard — у каждого раздела свой файл базы.
+//
+// Брони по ID находятся через BookingLocator. Операции над несколькими
+// разделами (групповая бронь, перенос брони на станцию другого раздела)
+// выполняются в вызывающем потоке: он по очереди, в порядке возрастания
+// номеров, останавливает нужные разделы барьером и работает с их движками
+// сам — без общего мьютекса и без взаимной блокировки координаторов.
+// Такие операции идут отдельными транзакциями разделов; при отказе
+// посередине уже сделанные шаги отменяются компенсирующими операциями.
+//
+// Запросы isFree, workstationsWithStatus и bookingsForDay не идут в очередь
+// раздела: они читают опубликованные версии расписания (SchedulePublisher)
+// без блокировок и никогда не ждут записи. Каждый раздел виден целостно, но
+// версии разных разделов берутся в разные моменты; версия раздела может
+// опережать COMMIT его текущей пачки.
+//
+// Методы потокобезопасны; вызывать их из задач раздела (submit) нельзя.
+// Операция по ID брони, совпавшая с её переносом в другой раздел, может
+// вернуть BookingNotFound.
+class ShardedEngine {
+private:
+    struct Shard {
+        unsigned index = 0;
+        std::unique_ptr<BookingEngine> engine;
+        // Версии расписания раздела; переживают перезагрузку движка.
+        std::shared_ptr<SchedulePublisher> schedule = std::make_shared<SchedulePublisher>();
+        MpscQueue<std::unique_ptr<ShardTask>> inbox;
+        std::atomic<bool> sleeping{ false };
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        std::exception_ptr broken; // движок не удалось перезагрузить после сбоя COMMIT (engine пуст)
+        std::thread worker;
+    };
+
+    class ParkedShards;
+
+    ShardedEngineConfig config;
+    std::vector<std::unique_ptr<Shard>> shards;
+    BookingLocator locator;
+    std::atomic<bool> stopping{ false };
+
+    EngineConfig shardConfig(const Shard& shard) const;
+    void registerBookings(Shard& shard);
+    void run(Shard& shard);
+    void sleep(Shard& shard);
+    void reload(Shard& shard);
+    void collectExpired(Shard& shard);
+    void releaseExpired(const std::vector<PurgeResult>& purged);
+    void post(Shard& shard, std::unique_ptr<ShardTask> task);
+    EngineResult moveBooking(const BookingRequest& request, unsigned from, unsigned to);
+
+    template <typename R>
+    static std::future<R> ready(R value) {
+        std::promise<R> promise;
+        promise.set_value(std::move(value));
+        return promise.get_future();
+    }
+
+public:
+    explicit ShardedEngine(const ShardedEngineConfig& config = ShardedEngineConfig());
+    ~ShardedEngine();
+    ShardedEngine(const ShardedEngine&) = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+    unsigned shardCount() const { return static_cast<unsigned>(shards.size()); }
+    unsigned shardFor(int workstationId) const { return shardOf(workstationId, shardCount()); }
+
+    // Выполняет body потоком раздела; future завершается после COMMIT пачки.
+    template <typename F>
+    auto submit(unsigned shard, F body) -> std::future<std::invoke_result_t<F, BookingEngine&>> {
+        using R = std::invoke_result_t<F, BookingEngine&>;
+        auto task = std::make_unique<FunctionShardTask<R>>(std::move(body));
+        std::future<R> result = task->getFuture();
+        post(*shards[shard], std::move(task));
+        return result;
+    }
+
+    // Станции.
+    std::future<EngineResult> addWorkstation(const AnyWorkstation& ws);
+    std::future<EngineResult> deleteWorkstation(int id);
+    std::future<EngineResult> setWorkstationStatus(int id, WorkstationStatus newStatus);
+
+    // Брони. Перенос брони в раздел другой станции выполняется сразу, в
+    // вызывающем потоке; возвращённый future уже готов.
+    std::future<EngineResult> addBooking(const BookingRequest& request);
+    std::future<EngineResult> updateBooking(const BookingRequest& request);
+    std::future<EngineResult> cancelBooking(int bookingId);
+    // Групповая бронь: добавляются все брони или ни одной. Результат —
+    // первой отклонённой брони (или успех с workstationBooked, если хоть
+    // одна станция перешла в booked).
+    EngineResult addGroupBooking(const std::vector<BookingRequest>& requests);
+
+    // Запросы.
+    std::future<std::optional<Booking>> findBooking(int bookingId);
+    bool hasWorkstation(int workstationId) const { return readSchedule(shardFor(workstationId))->find(workstationId) != nullptr; }
+    bool isFree(int workstationId, Date day, TimeOfDay start, TimeOfDay end) const;
+    // По версиям расписания всех разделов; ID по возрастанию.
+    std::vector<int> workstationIds() const;
+    std::vector<int> workstationsWithStatus(WorkstationStatus status) const;
+    std::vector<int> bookingsForDay(Date day) const;
+    std::vector<int> freeWorkstations(Date day, TimeOfDay start, TimeOfDay end) const;
+    SchedulePublisher::Reader readSchedule(unsigned shard) const { return shards[shard]->schedule->read(); }
+
+    // Каждый раздел удаляет свои закончившиеся брони; результаты объединяются.
+    PurgeResult purgeExpired(std::chrono::system_clock::time_point now = std::chrono::system_clock::now());
+};
+
+#endif // SHARDED_ENGINE_H
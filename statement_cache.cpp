@@ -0,0 +1,76 @@
+#include "statement_cache.h"
+#include <sqlite3.h>
+
+using namespace std;
+
+StatementCache::StatementCache(sqlite3* _db) : db(_db) {}
+
+StatementCache::~StatementCache() {
+    clear();
+}
+
+sqlite3_stmt* StatementCache::acquire(const char* sql, bool& owned) {
+    owned = false;
+    auto it = statements.find(string_view(sql));
+    if (it != statements.end() && !it->second.inUse) {
+        ++stats.hits;
+        it->second.inUse = true;
+        return it->second.stmt;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    unsigned int flags = it == statements.end() ? SQLITE_PREPARE_PERSISTENT : 0;
+    if (sqlite3_prepare_v3(db, sql, -1, flags, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    if (it != statements.end()) {
+        ++stats.copies;
+        owned = true;
+    } else {
+        ++stats.misses;
+        auto text = make_unique<string>(sql);
+        string_view key(*text);
+        Entry& entry = statements.emplace(key, Entry{ move(text), stmt, true }).first->second;
+        entries.emplace(stmt, &entry);
+    }
+    return stmt;
+}
+
+void StatementCache::release(sqlite3_stmt* stmt) {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    auto it = entries.find(stmt);
+    if (it != entries.end()) {
+        it->second->inUse = false;
+    }
+}
+
+void StatementCache::clear() {
+    for (auto& entry : statements) {
+        sqlite3_finalize(entry.second.stmt);
+    }
+    statements.clear();
+    entries.clear();
+}
+
+CachedStatement::CachedStatement(StatementCache& _cache, const char* sql) : cache(&_cache), stmt(nullptr), owned(false) {
+    stmt = cache->acquire(sql, owned);
+}
+
+CachedStatement::CachedStatement(CachedStatement&& other) noexcept
+    : cache(other.cache), stmt(other.stmt), owned(other.owned) {
+    other.stmt = nullptr;
+    other.owned = false;
+}
+
+CachedStatement::~CachedStatement() {
+    if (!stmt) {
+        return;
+    }
+    if (owned) {
+        sqlite3_finalize(stmt);
+    } else {
+        cache->release(stmt);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef STATEMENT_CACHE_H
+#define STATEMENT_CACHE_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstddef>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+struct StatementCacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t copies = 0; // отдельные копии для вложенных выборок того же SQL
+};
+
+// Кэш подготовленных запросов: каждый SQL-текст компилируется один раз,
+// дальше объект запроса переиспользуется через sqlite3_reset.
+class StatementCache {
+private:
+    struct Entry {
+        std::unique_ptr<std::string> sql; // на этот текст указывает ключ в statements
+        sqlite3_stmt* stmt;
+        bool inUse; // выдан CachedStatement и ещё не возвращён
+    };
+
+    sqlite3* db;
+    // Ключ — string_view: поиск по тексту запроса не создаёт std::string.
+    std::unordered_map<std::string_view, Entry> statements;
+    // Те же записи по объекту запроса — для release.
+    std::unordered_map<sqlite3_stmt*, Entry*> entries;
+    StatementCacheStats stats;
+
+public:
+    explicit StatementCache(sqlite3* _db);
+    ~StatementCache();
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    // Если закэшированный запрос уже выдан (открытый курсор или ещё не
+    // выполненный запрос с параметрами), возвращается отдельная копия
+    // с owned = true, которую нужно финализировать.
+    sqlite3_stmt* acquire(const char* sql, bool& owned);
+    // Возвращает выданный из кэша запрос: сбрасывает его и снимает отметку.
+    void release(sqlite3_stmt* stmt);
+    void clear();
+
+    StatementCacheStats getStats() const { return stats; }
+};
+
+// Берёт запрос из кэша и при выходе из области видимости сбрасывает его
+// (sqlite3_reset + sqlite3_clear_bindings), чтобы он был готов к следующему вызову.
+class CachedStatement {
+private:
+    StatementCache* cache;
+    sqlite3_stmt* stmt;
+    bool owned;
+
+public:
+    CachedStatement(StatementCache& cache, const char* sql);
+    ~CachedStatement();
+    CachedStatement(const CachedStatement&) = delete;
+    CachedStatement& operator=(const CachedStatement&) = delete;
+    CachedStatement(CachedStatement&& other) noexcept;
+    CachedStatement& operator=(CachedStatement&&) = delete;
+
+    sqlite3_stmt* get() const { return stmt; }
+    explicit operator bool() const { return stmt != nullptr; }
+};
+
+#endif // STATEMENT_CACHE_H
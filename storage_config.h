@@ -0,0 +1,35 @@
+#ifndef STORAGE_CONFIG_H
+#define STORAGE_CONFIG_H
+
+#include <string>
+
+enum class SynchronousLevel {
+    Off,
+    Normal,
+    Full,
+    Extra
+};
+
+// Параметры открытия booking.db. Профиль по умолчанию — WAL + synchronous=NORMAL:
+// читатели не блокируются писателем, фиксация не ждёт fsync основного файла,
+// а после сбоя приложения база остаётся целостной (при отключении питания
+// могут потеряться только последние зафиксированные транзакции).
+struct StorageConfig {
+    std::string path = "booking.db";
+    bool walMode = true;
+    SynchronousLevel synchronous = SynchronousLevel::Normal;
+    int cacheSizeKiB = 16 * 1024;
+    long long mmapSizeBytes = 256LL * 1024 * 1024;
+    int busyTimeoutMs = 5000;
+
+    static StorageConfig durableFast() { return StorageConfig(); }
+
+    // Каждая фиксация ждёт fsync: медленнее, но без потерь при отключении питания.
+    static StorageConfig strict() {
+        StorageConfig config;
+        config.synchronous = SynchronousLevel::Full;
+        return config;
+    }
+};
+
+#endif // STORAGE_CONFIG_H
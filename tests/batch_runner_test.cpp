@@ -0,0 +1,123 @@
+// Пакетный режим: команды JSONL на входе, строки результатов на выходе,
+// изменения в базе после переоткрытия — с обычной фиксацией и с writeBehind.
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../batch_runner.h"
+#include "../booking_engine.h"
+#include "test_support.h"
+
+using namespace std;
+
+static vector<string> splitLines(const string& text) {
+    vector<string> lines;
+    istringstream in(text);
+    for (string line; getline(in, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static bool contains(const string& line, const string& part) {
+    return line.find(part) != string::npos;
+}
+
+static void testRoundTrip(bool writeBehind) {
+    EngineConfig config;
+    config.storage = freshStorage("kpk_batch_runner_test.db");
+    config.backgroundExpiry = false;
+    config.writeBehind = writeBehind;
+    string day = dayFromToday(1).toString();
+
+    string commands =
+        "{\"op\":\"add_workstation\",\"id\":1,\"name\":\"Станция 1\"}\n"
+        "{\"op\":\"add_workstation\",\"id\":2,\"name\":\"Станция 2\",\"rating\":4}\n"
+        "\n"
+        "{\"op\":\"add_booking\",\"id\":10,\"workstation\":1,\"client\":\"Иван\",\"date\":\"" + day + "\",\"start\":\"10:00\",\"end\":\"11:00\"}\n"
+        "{\"op\":\"add_booking\",\"id\":11,\"workstation\":1,\"client\":\"Ольга\",\"date\":\"" + day + "\",\"start\":\"10:30\",\"end\":\"12:00\"}\n"
+        "{\"op\":\"update_booking\",\"id\":10,\"start\":\"13:00\",\"end\":\"14:00\"}\n"
+        "{\"op\":\"add_booking\",\"id\":12,\"workstation\":2,\"client\":\"Ольга\",\"date\":\"" + day + "\",\"start\":\"09:00\",\"end\":\"10:00\"}\n"
+        "{\"op\":\"cancel_booking\",\"id\":12}\n"
+        "{\"op\":\"get_booking\",\"id\":10}\n"
+        "{\"op\":\"is_free\",\"date\":\"" + day + "\",\"start\":\"13:30\",\"end\":\"15:00\"}\n"
+        "{\"op\":\"list_workstations\",\"status\":\"booked\"}\n"
+        "{\"op\":\"no_such_op\"}\n"
+        "not json\n";
+
+    istringstream in(commands);
+    ostringstream out;
+    BatchOptions options;
+    options.commitEvery = 3;
+    options.chunkLines = 2;
+    {
+        BookingEngine engine(config);
+        BatchSummary summary = runBatch(engine, in, out, options);
+        CHECK_EQ(summary.commands, 12u);
+        CHECK_EQ(summary.succeeded, 9u);
+        CHECK_EQ(summary.rejected, 1u);
+        CHECK_EQ(summary.invalid, 2u);
+        CHECK_EQ(summary.failed, 0u);
+        CHECK_EQ(summary.commits, 4u);
+    }
+
+    vector<string> lines = splitLines(out.str());
+    CHECK_EQ(lines.size(), 12u);
+    if (lines.size() == 12) {
+        CHECK(contains(lines[0], "\"line\":1,") && contains(lines[0], "\"status\":\"ok\""));
+        CHECK(contains(lines[2], "\"line\":4,") && contains(lines[2], "\"workstation_booked\":true"));
+        CHECK(contains(lines[3], "\"status\":\"conflict\""));
+        CHECK(contains(lines[6], "\"workstation_released\":true"));
+        CHECK(contains(lines[7], "\"start\":\"13:00\"") && contains(lines[7], "\"client\":\"Иван\""));
+        CHECK(contains(lines[8], "\"free\":[2]"));
+        CHECK(contains(lines[9], "\"ids\":[1]"));
+        CHECK(contains(lines[10], "\"status\":\"invalid\""));
+        CHECK(contains(lines[11], "\"line\":13,") && contains(lines[11], "\"status\":\"invalid\""));
+    }
+
+    // То, что выведено как ok, уже в базе.
+    config.writeBehind = false;
+    BookingEngine reopened(config);
+    CHECK_EQ(reopened.getWorkstations().size(), 2u);
+    CHECK(reopened.findBooking(10) && reopened.findBooking(10)->getStartTime().totalMinutes() == 13 * 60);
+    CHECK(!reopened.findBooking(11));
+    CHECK(!reopened.findBooking(12));
+    CHECK(baseOf(*reopened.findWorkstation(1)).getStatus() == WorkstationStatus::Booked);
+    CHECK(baseOf(*reopened.findWorkstation(2)).getStatus() == WorkstationStatus::Available);
+}
+
+// ID вне диапазона отклоняется, а не превращается после переполнения в
+// ID другой брони: 18446744073709551620 = 2^64 + 4.
+static void testOversizedId() {
+    EngineConfig config;
+    config.storage = freshStorage("kpk_batch_runner_test.db");
+    config.backgroundExpiry = false;
+    BookingEngine engine(config);
+    CHECK(engine.addWorkstation(Workstation(1, "Станция 1")).ok());
+    CHECK(engine.addBooking({ 4, 1, "Иван", dayFromToday(1), TimeOfDay(10, 0), TimeOfDay(11, 0) }).ok());
+
+    istringstream in("{\"op\":\"cancel_booking\",\"id\":18446744073709551620}\n"
+                     "{\"op\":\"cancel_booking\",\"id\":4294967300}\n"
+                     "{\"op\":\"delete_workstation\",\"id\":-18446744073709551615}\n");
+    ostringstream out;
+    BatchSummary summary = runBatch(engine, in, out, BatchOptions());
+    CHECK_EQ(summary.invalid, 3u);
+    CHECK_EQ(summary.succeeded, 0u);
+    for (const string& line : splitLines(out.str())) {
+        CHECK(contains(line, "\"status\":\"invalid\""));
+    }
+    CHECK(engine.findBooking(4));
+    CHECK(engine.findWorkstation(1) != nullptr);
+}
+
+int main() {
+    try {
+        testRoundTrip(false);
+        testRoundTrip(true);
+        testOversizedId();
+    } catch (const exception& e) {
+        cerr << "исключение: " << e.what() << "\n";
+        return 1;
+    }
+    return testResult("batch_runner_test");
+}
@@ -0,0 +1,141 @@
+// BookingEngine: добавление, перенос, отмена и истечение броней на временной базе.
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include "../booking_engine.h"
+#include "../booking_manager.h"
+#include "test_support.h"
+
+using namespace std;
+
+static EngineConfig testConfig() {
+    EngineConfig config;
+    config.storage = freshStorage("kpk_booking_engine_test.db");
+    config.backgroundExpiry = false;
+    return config;
+}
+
+static void testAddUpdateCancel(const EngineConfig& config) {
+    BookingEngine engine(config);
+    Date tomorrow = dayFromToday(1);
+
+    CHECK(engine.addWorkstation(Workstation(1, "Станция 1")).ok());
+    CHECK(engine.addWorkstation(SpecialWorkstation(2, "Станция 2", WorkstationStatus::Available, 5)).ok());
+    CHECK(engine.addWorkstation(Workstation(1, "Дубликат")).error == EngineError::DuplicateWorkstation);
+
+    EngineResult added = engine.addBooking({ 10, 1, "Иван", tomorrow, TimeOfDay(10, 0), TimeOfDay(11, 0) });
+    CHECK(added.ok());
+    CHECK(added.workstationBooked);
+    CHECK(baseOf(*engine.findWorkstation(1)).getStatus() == WorkstationStatus::Booked);
+
+    EngineResult conflict = engine.addBooking({ 11, 1, "Ольга", tomorrow, TimeOfDay(10, 30), TimeOfDay(11, 30) });
+    CHECK(conflict.error == EngineError::Conflict);
+    CHECK(conflict.conflictingIds == vector<int>{ 10 });
+    CHECK(engine.addBooking({ 10, 2, "Ольга", tomorrow, TimeOfDay(8, 0), TimeOfDay(9, 0) }).error == EngineError::DuplicateBooking);
+    CHECK(engine.addBooking({ 12, 1, "Ольга", dayFromToday(-1), TimeOfDay(8, 0), TimeOfDay(9, 0) }).error == EngineError::InPast);
+    CHECK(engine.addBooking({ 12, 1, "Ольга", tomorrow, TimeOfDay(9, 0), TimeOfDay(9, 0) }).error == EngineError::InvalidInterval);
+    CHECK(engine.addBooking({ 12, 9, "Ольга", tomorrow, TimeOfDay(9, 0), TimeOfDay(10, 0) }).error == EngineError::WorkstationNotFound);
+
+    CHECK(engine.updateBooking({ 10, 1, "", tomorrow, TimeOfDay(12, 0), TimeOfDay(13, 0) }).ok());
+    CHECK(engine.isFree(1, tomorrow, TimeOfDay(10, 0), TimeOfDay(11, 0)));
+    CHECK(!engine.isFree(1, tomorrow, TimeOfDay(12, 30), TimeOfDay(14, 0)));
+    optional<Booking> moved = engine.findBooking(10);
+    CHECK(moved && moved->getStartTime().totalMinutes() == 12 * 60);
+    CHECK(moved && engine.getClients().nameOf(moved->getClientId()) == "Иван");
+    CHECK(engine.freeWorkstations(tomorrow, TimeOfDay(12, 0), TimeOfDay(12, 30)) == vector<int>{ 2 });
+
+    CHECK(engine.addBooking({ 11, 1, "Ольга", tomorrow, TimeOfDay(10, 30), TimeOfDay(11, 30) }).ok());
+    CHECK_EQ(engine.bookingsForDay(tomorrow).size(), 2u);
+
+    EngineResult cancelled = engine.cancelBooking(11);
+    CHECK(cancelled.ok());
+    CHECK(!cancelled.workstationReleased); // бронь 10 ещё активна
+    cancelled = engine.cancelBooking(10);
+    CHECK(cancelled.ok());
+    CHECK(cancelled.workstationReleased);
+    CHECK(baseOf(*engine.findWorkstation(1)).getStatus() == WorkstationStatus::Available);
+    CHECK(engine.cancelBooking(10).error == EngineError::BookingNotFound);
+
+    // Снимок расписания совпадает с данными движка.
+    SchedulePublisher::Reader snapshot = engine.readSchedule();
+    CHECK_EQ(snapshot->getStations().size(), 2u);
+    CHECK_EQ(snapshot->bookingCount(), 0u);
+}
+
+static void testExpire(const EngineConfig& config) {
+    Date tomorrow = dayFromToday(1);
+    {
+        BookingEngine engine(config);
+        CHECK(engine.addBooking({ 20, 1, "Иван", tomorrow, TimeOfDay(8, 0), TimeOfDay(9, 0) }).ok());
+        CHECK(engine.addBooking({ 21, 2, "Ольга", dayFromToday(5), TimeOfDay(8, 0), TimeOfDay(9, 0) }).ok());
+
+        // Через три дня первая бронь закончилась, вторая — ещё нет.
+        PurgeResult purged = engine.purgeExpired(chrono::system_clock::now() + chrono::hours(72));
+        CHECK(purged.bookingIds == vector<int>{ 20 });
+        CHECK(purged.releasedWorkstationIds == vector<int>{ 1 });
+        CHECK(!engine.findBooking(20));
+        CHECK(engine.findBooking(21));
+        CHECK(baseOf(*engine.findWorkstation(1)).getStatus() == WorkstationStatus::Available);
+        CHECK(baseOf(*engine.findWorkstation(2)).getStatus() == WorkstationStatus::Booked);
+    }
+
+    // После переоткрытия база совпадает с тем, что было в памяти.
+    BookingEngine reopened(config);
+    CHECK_EQ(reopened.getWorkstations().size(), 2u);
+    CHECK(!reopened.findBooking(20));
+    CHECK(reopened.findBooking(21));
+    CHECK(baseOf(*reopened.findWorkstation(2)).getStatus() == WorkstationStatus::Booked);
+}
+
+// Бронь удалена в базе другим соединением (как это делает ExpiryScheduler),
+// а в памяти движка ещё есть: изменение должно вернуть BookingNotFound.
+static void testBookingDeletedBehindEngine(const EngineConfig& config) {
+    BookingEngine engine(config);
+    Date later = dayFromToday(3);
+    CHECK(engine.addBooking({ 30, 1, "Иван", later, TimeOfDay(8, 0), TimeOfDay(9, 0) }).ok());
+    CHECK(engine.addBooking({ 31, 1, "Иван", later, TimeOfDay(10, 0), TimeOfDay(11, 0) }).ok());
+    {
+        BookingManager other(config.storage);
+        CHECK(other.deleteBooking(30));
+        CHECK(other.deleteBooking(31));
+        CHECK(!other.deleteBooking(31));
+    }
+    CHECK(engine.updateBooking({ 30, 1, "", later, TimeOfDay(12, 0), TimeOfDay(13, 0) }).error == EngineError::BookingNotFound);
+    CHECK(engine.cancelBooking(31).error == EngineError::BookingNotFound);
+    // Отклонённая отмена не трогает статус станции.
+    CHECK(baseOf(*engine.findWorkstation(1)).getStatus() == WorkstationStatus::Booked);
+}
+
+// reload() приводит память к базе: станция, добавленная другим соединением,
+// появляется, удалённая бронь исчезает.
+static void testReload(const EngineConfig& config) {
+    BookingEngine engine(config);
+    Date later = dayFromToday(3);
+    CHECK(engine.addBooking({ 40, 1, "Иван", later, TimeOfDay(8, 0), TimeOfDay(9, 0) }).ok());
+    {
+        BookingManager other(config.storage);
+        other.addWorkstation(Workstation(3, "Станция 3"));
+        CHECK(other.deleteBooking(40));
+    }
+    engine.reload();
+    CHECK(engine.findWorkstation(3) != nullptr);
+    CHECK(!engine.findBooking(40));
+    CHECK(engine.isFree(1, later, TimeOfDay(8, 0), TimeOfDay(9, 0)));
+    CHECK(engine.addBooking({ 40, 3, "Ольга", later, TimeOfDay(8, 0), TimeOfDay(9, 0) }).ok());
+    CHECK(engine.readSchedule()->find(3) != nullptr);
+}
+
+int main() {
+    EngineConfig config = testConfig();
+    try {
+        testAddUpdateCancel(config);
+        testExpire(config);
+        testBookingDeletedBehindEngine(config);
+        testReload(config);
+    } catch (const exception& e) {
+        cerr << "исключение: " << e.what() << "\n";
+        return 1;
+    }
+    return testResult("booking_engine_test");
+}
@@ -0,0 +1,331 @@
+// Сервер на loopback: запросы по TCP и Unix-сокету, конвейер запросов с
+// ответами больше maxPendingOutput, полузакрытое соединение, слишком
+// длинная строка, база, занятая другим соединением, и сервер над ShardedEngine.
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../booking_engine.h"
+#include "../booking_manager.h"
+#include "../booking_server.h"
+#include "../sharded_engine.h"
+#include "test_support.h"
+
+using namespace std;
+
+static int connectTcp(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int connectUnix(const string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Читает, пока не придут lines строк или сервер не закроет соединение;
+// ждёт не дольше 5 с без новых данных. eof — сервер закрыл соединение.
+static vector<string> readLines(int fd, size_t lines, bool& eof) {
+    vector<string> result;
+    string buffer;
+    eof = false;
+    char chunk[16 * 1024];
+    while (result.size() < lines) {
+        pollfd p{ fd, POLLIN, 0 };
+        if (poll(&p, 1, 5000) <= 0) {
+            break;
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            eof = true;
+            break;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+        size_t newline;
+        while ((newline = buffer.find('\n')) != string::npos) {
+            result.push_back(buffer.substr(0, newline));
+            buffer.erase(0, newline + 1);
+        }
+    }
+    return result;
+}
+
+static bool waitForEof(int fd) {
+    char chunk[1024];
+    for (;;) {
+        pollfd p{ fd, POLLIN, 0 };
+        if (poll(&p, 1, 5000) <= 0) {
+            return false;
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n == 0) {
+            return true;
+        }
+        if (n < 0) {
+            return false;
+        }
+    }
+}
+
+static bool contains(const string& line, const string& part) {
+    return line.find(part) != string::npos;
+}
+
+// Ответ на list_workstations занимает больше 1 КБ, а предел исходящих
+// данных — 16 КБ: выполнение 200 запросов много раз упирается в предел.
+static void testPipelining(uint16_t port, size_t requests) {
+    int fd = connectTcp(port);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+    string batch;
+    for (size_t i = 0; i < requests; ++i) {
+        batch += "{\"op\":\"list_workstations\"}\n";
+    }
+    CHECK(sendAll(fd, batch));
+    bool eof;
+    vector<string> lines = readLines(fd, requests, eof);
+    CHECK_EQ(lines.size(), requests);
+    CHECK(!lines.empty() && contains(lines.back(), "\"line\":" + to_string(requests) + ","));
+    ::close(fd);
+}
+
+// Клиент отправил запросы и закрыл свою сторону: ответы приходят все,
+// затем сервер закрывает соединение.
+static void testHalfClose(uint16_t port, size_t requests) {
+    int fd = connectTcp(port);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+    string batch;
+    for (size_t i = 0; i < requests; ++i) {
+        batch += "{\"op\":\"list_workstations\"}\n";
+    }
+    batch += "{\"op\":\"get_booking\",\"id\":1}"; // последняя строка без перевода строки
+    CHECK(sendAll(fd, batch));
+    shutdown(fd, SHUT_WR);
+    bool eof;
+    vector<string> lines = readLines(fd, requests + 1, eof);
+    CHECK_EQ(lines.size(), requests + 1);
+    CHECK(!lines.empty() && contains(lines.back(), "\"status\":\"booking_not_found\""));
+    CHECK(waitForEof(fd));
+    ::close(fd);
+}
+
+static void testUnixAndOversize(const string& path, size_t maxRequestBytes) {
+    int fd = connectUnix(path);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+    CHECK(sendAll(fd, "{\"op\":\"add_workstation\",\"id\":5000,\"name\":\"Новая\"}\n" + string(maxRequestBytes + 10, 'x')));
+    bool eof;
+    vector<string> lines = readLines(fd, 2, eof);
+    CHECK_EQ(lines.size(), 2u);
+    if (lines.size() == 2) {
+        CHECK(contains(lines[0], "\"status\":\"ok\""));
+        CHECK(contains(lines[1], "\"line\":2,") && contains(lines[1], "\"status\":\"invalid\""));
+    }
+    CHECK(waitForEof(fd));
+    ::close(fd);
+}
+
+// Пока другое соединение держит блокировку записи, запросы получают ответ
+// error, а сервер продолжает работу; после снятия блокировки всё как обычно.
+static void testLockedStorage(uint16_t port, const StorageConfig& storage) {
+    int fd = connectTcp(port);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+    bool eof;
+    {
+        BookingManager other(storage);
+        UnitOfWork lock(other);
+        CHECK(sendAll(fd, "{\"op\":\"add_workstation\",\"id\":6000,\"name\":\"Первая\"}\n"
+                          "{\"op\":\"list_workstations\"}\n"));
+        vector<string> lines = readLines(fd, 2, eof);
+        CHECK_EQ(lines.size(), 2u);
+        for (const string& line : lines) {
+            CHECK(contains(line, "\"status\":\"error\""));
+        }
+    }
+    CHECK(sendAll(fd, "{\"op\":\"add_workstation\",\"id\":6000,\"name\":\"Вторая\"}\n"));
+    vector<string> lines = readLines(fd, 1, eof);
+    CHECK_EQ(lines.size(), 1u);
+    CHECK(!lines.empty() && contains(lines[0], "\"line\":3,") && contains(lines[0], "\"status\":\"ok\""));
+    CHECK(!eof);
+    ::close(fd);
+}
+
+// Клиент client шлёт конвейером цепочку, где каждый запрос зависит от
+// предыдущего: добавить бронь, перенести её на станцию другого раздела,
+// прочитать, отменить.
+static void testShardedClient(uint16_t port, int client, const string& day) {
+    int fd = connectTcp(port);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+    string id = to_string(100 + client);
+    string from = to_string(client + 1);
+    string to = to_string(client + 2);
+    CHECK(sendAll(fd, "{\"op\":\"add_booking\",\"id\":" + id + ",\"workstation\":" + from +
+                          ",\"client\":\"Клиент " + id + "\",\"date\":\"" + day + "\",\"start\":\"10:00\",\"end\":\"11:00\"}\n"
+                      "{\"op\":\"update_booking\",\"id\":" + id + ",\"workstation\":" + to + ",\"start\":\"12:00\",\"end\":\"13:00\"}\n"
+                      "{\"op\":\"get_booking\",\"id\":" + id + "}\n"
+                      "{\"op\":\"is_free\",\"workstation\":" + to + ",\"date\":\"" + day + "\",\"start\":\"12:30\",\"end\":\"13:30\"}\n"
+                      "{\"op\":\"cancel_booking\",\"id\":" + id + "}\n"
+                      "{\"op\":\"get_booking\",\"id\":" + id + "}\n"));
+    bool eof;
+    vector<string> lines = readLines(fd, 6, eof);
+    CHECK_EQ(lines.size(), 6u);
+    if (lines.size() == 6) {
+        CHECK(contains(lines[0], "\"status\":\"ok\""));
+        CHECK(contains(lines[1], "\"status\":\"ok\""));
+        CHECK(contains(lines[2], "\"workstation\":" + to + ",") && contains(lines[2], "\"client\":\"Клиент " + id + "\"") &&
+              contains(lines[2], "\"start\":\"12:00\""));
+        CHECK(contains(lines[3], "\"free\":false"));
+        CHECK(contains(lines[4], "\"status\":\"ok\""));
+        CHECK(contains(lines[5], "\"line\":6,") && contains(lines[5], "\"status\":\"booking_not_found\""));
+    }
+    ::close(fd);
+}
+
+static void testShardedServer() {
+    ShardedEngineConfig shardedConfig;
+    shardedConfig.engine.storage = freshStorage("kpk_booking_server_test.db");
+    shardedConfig.engine.backgroundExpiry = false;
+    shardedConfig.shards = 4;
+    ServerConfig config;
+    config.tcpPort = 0;
+
+    ShardedEngine engine(shardedConfig);
+    for (int id = 1; id <= 10; ++id) {
+        engine.addWorkstation(Workstation(id, "Станция " + to_string(id))).get();
+    }
+    BookingServer server(engine, config);
+    thread loop([&] { server.run(); });
+
+    string day = dayFromToday(1).toString();
+    vector<thread> clients;
+    for (int client = 0; client < 8; ++client) {
+        clients.emplace_back([&, client] { testShardedClient(server.tcpPort(), client, day); });
+    }
+    for (thread& client : clients) {
+        client.join();
+    }
+    // Запрос по всем разделам.
+    int fd = connectTcp(server.tcpPort());
+    CHECK(sendAll(fd, "{\"op\":\"list_workstations\"}\n{\"op\":\"is_free\",\"date\":\"" + day +
+                          "\",\"start\":\"08:00\",\"end\":\"09:00\"}\n"));
+    bool eof;
+    vector<string> lines = readLines(fd, 2, eof);
+    CHECK_EQ(lines.size(), 2u);
+    if (lines.size() == 2) {
+        CHECK(contains(lines[0], "\"ids\":[1,2,3,4,5,6,7,8,9,10]"));
+        CHECK(contains(lines[1], "\"free\":[1,2,3,4,5,6,7,8,9,10]"));
+    }
+    ::close(fd);
+
+    server.stop();
+    loop.join();
+    CHECK_EQ(server.getSummary().commands, 8u * 6 + 2);
+    CHECK_EQ(server.getSummary().failed, 0u);
+    CHECK(engine.bookingsForDay(dayFromToday(1)).empty());
+}
+
+int main() {
+    EngineConfig engineConfig;
+    engineConfig.storage = freshStorage("kpk_booking_server_test.db");
+    engineConfig.storage.busyTimeoutMs = 50;
+    engineConfig.backgroundExpiry = false;
+    string unixPath = "kpk_booking_server_test.sock";
+
+    ServerConfig config;
+    config.tcpPort = 0;
+    config.unixPath = unixPath;
+    config.maxPendingOutput = 16 * 1024;
+    config.maxRequestBytes = 4 * 1024;
+    config.expiryPollMs = 50;
+
+    try {
+        BookingEngine engine(engineConfig);
+        for (int id = 1; id <= 300; ++id) {
+            engine.addWorkstation(Workstation(id, "Станция " + to_string(id)));
+        }
+        BookingServer server(engine, config);
+        thread loop([&] { server.run(); });
+
+        testPipelining(server.tcpPort(), 200);
+        testHalfClose(server.tcpPort(), 200);
+        testUnixAndOversize(unixPath, config.maxRequestBytes);
+
+        // Несколько клиентов одновременно.
+        vector<thread> clients;
+        for (int i = 0; i < 8; ++i) {
+            clients.emplace_back([&] { testPipelining(server.tcpPort(), 50); });
+        }
+        for (thread& client : clients) {
+            client.join();
+        }
+
+        CHECK_EQ(server.getSummary().failed, 0u);
+        testLockedStorage(server.tcpPort(), engineConfig.storage);
+
+        server.stop();
+        loop.join();
+        CHECK_EQ(server.getSummary().failed, 2u);
+        CHECK(engine.findWorkstation(5000) != nullptr);
+        CHECK(engine.findWorkstation(6000) != nullptr);
+    } catch (const exception& e) {
+        cerr << "исключение: " << e.what() << "\n";
+        return 1;
+    }
+    CHECK(access(unixPath.c_str(), F_OK) != 0); // сокет удалён при остановке
+
+    try {
+        testShardedServer();
+    } catch (const exception& e) {
+        cerr << "исключение: " << e.what() << "\n";
+        return 1;
+    }
+    return testResult("booking_server_test");
+}
@@ -0,0 +1,119 @@
+// SchedulePublisher: читатели в других потоках во время публикаций видят
+// только целые версии, и версии не идут назад; EpochReclaimer не удаляет
+// то, что ещё читают.
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../booking.h"
+#include "../epoch_reclaimer.h"
+#include "../schedule_snapshot.h"
+#include "test_support.h"
+
+using namespace std;
+
+// Писатель переносит единственную бронь между станциями 1..20 и при этом
+// добавляет и удаляет станции 21..40. Каждая версия должна содержать ровно
+// одну бронь и станции по возрастанию ID.
+static void testConcurrentReaders() {
+    const int publishes = 20000;
+    Date day = dayFromToday(1);
+    SchedulePublisher publisher;
+    for (int id = 1; id <= 20; ++id) {
+        publisher.putStation(Workstation(id, "Станция " + to_string(id)));
+    }
+    publisher.addBooking(Booking(1, 1, 1, day, TimeOfDay(10, 0), TimeOfDay(11, 0)));
+    publisher.publish();
+
+    atomic<bool> stop{ false };
+    atomic<long> reads{ 0 };
+    vector<thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&] {
+            uint64_t last = 0;
+            while (!stop.load()) {
+                SchedulePublisher::Reader snapshot = publisher.read();
+                CHECK(snapshot->getVersion() >= last);
+                last = snapshot->getVersion();
+                CHECK_EQ(snapshot->bookingCount(), 1u);
+                CHECK(snapshot->bookingsForDay(day) == vector<int>{ 1 });
+                const vector<const StationSchedule*>& stations = snapshot->getStations();
+                for (size_t i = 1; i < stations.size(); ++i) {
+                    CHECK(stations[i - 1]->id() < stations[i]->id());
+                }
+                ++reads;
+            }
+        });
+    }
+
+    for (int i = 0; i < publishes; ++i) {
+        int from = i % 20 + 1;
+        int to = (i + 1) % 20 + 1;
+        publisher.removeBooking(from, 1);
+        publisher.addBooking(Booking(1, to, 1, day, TimeOfDay(10, 0), TimeOfDay(11, 0)));
+        int churn = 21 + i % 20;
+        if (i % 3 == 0) {
+            publisher.removeStation(churn);
+        } else {
+            publisher.putStation(Workstation(churn, "Станция " + to_string(churn)));
+        }
+        publisher.publish();
+    }
+    stop.store(true);
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    CHECK(reads.load() > 0);
+    CHECK_EQ(publisher.version(), static_cast<uint64_t>(publishes + 1));
+    CHECK(publisher.read()->find(publishes % 20 + 1) != nullptr);
+
+    // Открытый Reader держит свою версию; после него всё отложенное удаляется.
+    {
+        SchedulePublisher::Reader held = publisher.read();
+        uint64_t version = held->getVersion();
+        for (int i = 0; i < 3; ++i) {
+            publisher.setStatus(1, i % 2 ? WorkstationStatus::Available : WorkstationStatus::Maintenance);
+            publisher.publish();
+        }
+        CHECK(publisher.pendingReclaim() > 0);
+        CHECK_EQ(held->getVersion(), version);
+        CHECK_EQ(held->bookingCount(), 1u);
+    }
+    publisher.setStatus(1, WorkstationStatus::Available);
+    publisher.publish();
+    CHECK_EQ(publisher.pendingReclaim(), 0u);
+}
+
+struct Counted {
+    static atomic<int> alive;
+    Counted() { ++alive; }
+    ~Counted() { --alive; }
+};
+atomic<int> Counted::alive{ 0 };
+
+static void testReclaimer() {
+    EpochReclaimer reclaimer;
+    reclaimer.retire(new Counted);
+    CHECK_EQ(reclaimer.reclaim(), 1u);
+    {
+        EpochReclaimer::Guard guard = reclaimer.enter();
+        reclaimer.retire(new Counted);
+        reclaimer.retire(new Counted);
+        CHECK_EQ(reclaimer.reclaim(), 0u);
+        CHECK_EQ(reclaimer.pending(), 2u);
+        CHECK_EQ(Counted::alive.load(), 2);
+    }
+    CHECK_EQ(reclaimer.reclaim(), 2u);
+    CHECK_EQ(Counted::alive.load(), 0);
+}
+
+int main() {
+    try {
+        testReclaimer();
+        testConcurrentReaders();
+    } catch (const exception& e) {
+        cerr << "исключение: " << e.what() << "\n";
+        return 1;
+    }
+    return testResult("schedule_snapshot_test");
+}
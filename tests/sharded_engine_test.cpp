@@ -0,0 +1,121 @@
+// ShardedEngine: брони в разделах, переносы между разделами, групповые брони
+// с откатом и перезагрузка — с общей базой и с базой на раздел; задача,
+// для которой раздел не смог открыть транзакцию.
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../booking_manager.h"
+#include "../sharded_engine.h"
+#include "test_support.h"
+
+using namespace std;
+
+static ShardedEngineConfig testConfig(bool storagePerShard) {
+    ShardedEngineConfig config;
+    config.engine.storage = freshStorage("kpk_sharded_engine_test.db");
+    config.engine.backgroundExpiry = false;
+    config.shards = 4;
+    config.storagePerShard = storagePerShard;
+    for (unsigned shard = 0; shard < config.shards; ++shard) {
+        freshStorage(config.engine.storage.path + "." + to_string(shard));
+    }
+    return config;
+}
+
+static void testShards(bool storagePerShard) {
+    ShardedEngineConfig config = testConfig(storagePerShard);
+    Date day = dayFromToday(1);
+    {
+        ShardedEngine engine(config);
+        for (int id = 1; id <= 8; ++id) {
+            CHECK(engine.addWorkstation(Workstation(id, "Станция " + to_string(id))).get().ok());
+        }
+        CHECK(engine.shardFor(1) != engine.shardFor(2));
+
+        CHECK(engine.addBooking({ 1, 1, "Иван", day, TimeOfDay(10, 0), TimeOfDay(11, 0) }).get().ok());
+        // ID брони занят и в другом разделе.
+        CHECK(engine.addBooking({ 1, 2, "Ольга", day, TimeOfDay(10, 0), TimeOfDay(11, 0) }).get().error == EngineError::DuplicateBooking);
+        CHECK(engine.addBooking({ 2, 1, "Ольга", day, TimeOfDay(10, 30), TimeOfDay(11, 30) }).get().error == EngineError::Conflict);
+
+        // Перенос на станцию другого раздела.
+        EngineResult moved = engine.updateBooking({ 1, 2, "", day, TimeOfDay(12, 0), TimeOfDay(13, 0) }).get();
+        CHECK(moved.ok());
+        CHECK(moved.workstationReleased);
+        optional<Booking> booking = engine.findBooking(1).get();
+        CHECK(booking && booking->getWorkstationId() == 2);
+        CHECK(engine.isFree(1, day, TimeOfDay(10, 0), TimeOfDay(11, 0)));
+        CHECK(!engine.isFree(2, day, TimeOfDay(12, 30), TimeOfDay(13, 30)));
+        // Перенос, отклонённый целевым разделом, оставляет бронь на месте.
+        CHECK(engine.addBooking({ 3, 3, "Ольга", day, TimeOfDay(12, 0), TimeOfDay(13, 0) }).get().ok());
+        CHECK(engine.updateBooking({ 1, 3, "", day, TimeOfDay(12, 30), TimeOfDay(13, 30) }).get().error == EngineError::Conflict);
+        booking = engine.findBooking(1).get();
+        CHECK(booking && booking->getWorkstationId() == 2 && booking->getStartTime().totalMinutes() == 12 * 60);
+        CHECK(engine.cancelBooking(3).get().ok());
+
+        // Групповая бронь: все или ни одной.
+        EngineResult group = engine.addGroupBooking({ { 10, 3, "Группа", day, TimeOfDay(9, 0), TimeOfDay(10, 0) },
+                                                      { 11, 4, "Группа", day, TimeOfDay(9, 0), TimeOfDay(10, 0) },
+                                                      { 12, 5, "Группа", day, TimeOfDay(9, 0), TimeOfDay(10, 0) } });
+        CHECK(group.ok());
+        CHECK(group.workstationBooked);
+        group = engine.addGroupBooking({ { 20, 6, "Вторая", day, TimeOfDay(9, 0), TimeOfDay(10, 0) },
+                                         { 21, 7, "Вторая", day, TimeOfDay(9, 0), TimeOfDay(10, 0) },
+                                         { 22, 3, "Вторая", day, TimeOfDay(9, 30), TimeOfDay(10, 30) } });
+        CHECK(group.error == EngineError::Conflict);
+        CHECK(!engine.findBooking(20).get());
+        CHECK(!engine.findBooking(21).get());
+        CHECK(engine.workstationsWithStatus(WorkstationStatus::Booked) == vector<int>({ 2, 3, 4, 5 }));
+        CHECK(engine.bookingsForDay(day) == vector<int>({ 1, 10, 11, 12 }));
+
+        CHECK(engine.cancelBooking(10).get().ok());
+        CHECK(engine.deleteWorkstation(4).get().ok());
+        CHECK(!engine.findBooking(11).get());
+        // ID брони удалённой станции освободился.
+        CHECK(engine.addBooking({ 11, 5, "Иван", day, TimeOfDay(15, 0), TimeOfDay(16, 0) }).get().ok());
+    }
+
+    // После перезагрузки разделы и locator восстанавливаются из базы.
+    ShardedEngine reopened(config);
+    CHECK(reopened.bookingsForDay(day) == vector<int>({ 1, 11, 12 }));
+    CHECK(reopened.workstationsWithStatus(WorkstationStatus::Booked) == vector<int>({ 2, 5 }));
+    CHECK(reopened.addBooking({ 12, 1, "Ольга", day, TimeOfDay(1, 0), TimeOfDay(2, 0) }).get().error == EngineError::DuplicateBooking);
+    optional<Booking> booking = reopened.findBooking(1).get();
+    CHECK(booking && booking->getWorkstationId() == 2);
+}
+
+// Пока другое соединение держит блокировку записи, раздел не может начать
+// транзакцию: задача получает ошибку, поток раздела продолжает работу.
+static void testBusyStorage() {
+    ShardedEngineConfig config = testConfig(false);
+    config.engine.storage.busyTimeoutMs = 50;
+    ShardedEngine engine(config);
+    CHECK(engine.addWorkstation(Workstation(1, "Станция 1")).get().ok());
+
+    BookingManager other(config.engine.storage);
+    {
+        UnitOfWork lock(other);
+        future<EngineResult> blocked = engine.addWorkstation(Workstation(2, "Станция 2"));
+        bool failed = false;
+        try {
+            blocked.get();
+        } catch (const exception&) {
+            failed = true;
+        }
+        CHECK(failed);
+    }
+    CHECK(engine.addWorkstation(Workstation(2, "Станция 2")).get().ok());
+    CHECK(engine.workstationsWithStatus(WorkstationStatus::Available) == vector<int>({ 1, 2 }));
+}
+
+int main() {
+    try {
+        testShards(false);
+        testShards(true);
+        testBusyStorage();
+    } catch (const exception& e) {
+        cerr << "исключение: " << e.what() << "\n";
+        return 1;
+    }
+    return testResult("sharded_engine_test");
+}
@@ -0,0 +1,66 @@
+#ifndef KPK_TEST_SUPPORT_H
+#define KPK_TEST_SUPPORT_H
+
+// Общее для тестов: проверки без фреймворка и временные базы.
+// Тест — обычная программа: код возврата 0, если все CHECK прошли.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "../civil_date.h"
+#include "../storage_config.h"
+
+// Атомарный: проверки могут идти из нескольких потоков-клиентов.
+inline std::atomic<int>& testFailures() {
+    static std::atomic<int> failures{ 0 };
+    return failures;
+}
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": не выполнено: " #condition "\n"; \
+            ++testFailures();                                                              \
+        }                                                                                  \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                      \
+    do {                                                                                                \
+        const auto& checkActual = (actual);                                                             \
+        const auto& checkExpected = (expected);                                                         \
+        if (!(checkActual == checkExpected)) {                                                          \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #actual " = " << checkActual                \
+                      << ", ожидалось " << checkExpected << "\n";                                        \
+            ++testFailures();                                                                           \
+        }                                                                                               \
+    } while (0)
+
+inline int testResult(const char* name) {
+    if (testFailures() == 0) {
+        std::cerr << name << ": OK\n";
+        return 0;
+    }
+    std::cerr << name << ": ошибок " << testFailures() << "\n";
+    return 1;
+}
+
+// База в текущем каталоге без файлов от прошлого запуска; synchronous=OFF —
+// тестам не нужна устойчивость к отключению питания.
+inline StorageConfig freshStorage(const std::string& path) {
+    for (const char* suffix : { "", "-wal", "-shm", "-journal" }) {
+        std::remove((path + suffix).c_str());
+    }
+    StorageConfig storage;
+    storage.path = path;
+    storage.synchronous = SynchronousLevel::Off;
+    return storage;
+}
+
+// День через days дней от сегодняшнего по местному времени.
+inline Date dayFromToday(int days) {
+    return Date(toLocalDateTime(std::chrono::system_clock::now()).date.days() + days);
+}
+
+#endif // KPK_TEST_SUPPORT_H
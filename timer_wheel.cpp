@@ -0,0 +1,103 @@
+#include "timer_wheel.h"
+#include <utility>
+
+using namespace std;
+
+TimerWheel::TimerWheel(long long _current) : current(_current) {}
+
+// Запись попадает на самый нижний уровень, где её срок лежит в том же
+// блоке из 64^(k+1) минут, что и текущий момент: тогда её ячейка будет
+// разобрана раньше, чем срок наступит.
+void TimerWheel::place(const Entry& entry) {
+    if (entry.deadline <= current) {
+        due.push_back(entry);
+        return;
+    }
+    for (int level = 0; level < kLevels; ++level) {
+        int shift = kSlotBits * (level + 1);
+        if ((entry.deadline >> shift) == (current >> shift)) {
+            slots[level][(entry.deadline >> (kSlotBits * level)) & (kSlots - 1)].push_back(entry);
+            return;
+        }
+    }
+    overflow.push_back(entry);
+}
+
+void TimerWheel::cascade(vector<Entry>& bucket) {
+    vector<Entry> entries;
+    entries.swap(bucket);
+    for (const Entry& entry : entries) {
+        auto it = deadlines.find(entry.id);
+        if (it != deadlines.end() && it->second == entry.deadline) {
+            place(entry);
+        }
+    }
+}
+
+void TimerWheel::fire(vector<Entry>& bucket, vector<int>& fired) {
+    for (const Entry& entry : bucket) {
+        auto it = deadlines.find(entry.id);
+        if (it != deadlines.end() && it->second == entry.deadline) {
+            fired.push_back(entry.id);
+            deadlines.erase(it);
+        }
+    }
+    bucket.clear();
+}
+
+// После долгого простоя проще заново разложить все записи, чем проходить
+// колесо по минуте.
+void TimerWheel::rebuild(long long now, vector<int>& fired) {
+    vector<Entry> entries;
+    entries.swap(overflow);
+    entries.insert(entries.end(), due.begin(), due.end());
+    due.clear();
+    for (auto& level : slots) {
+        for (auto& bucket : level) {
+            entries.insert(entries.end(), bucket.begin(), bucket.end());
+            bucket.clear();
+        }
+    }
+    current = now;
+    cascade(entries);
+    fire(due, fired);
+}
+
+void TimerWheel::schedule(int id, long long deadline) {
+    auto [it, inserted] = deadlines.try_emplace(id, deadline);
+    if (!inserted) {
+        if (it->second == deadline) {
+            return;
+        }
+        it->second = deadline;
+    }
+    place(Entry{ id, deadline });
+}
+
+bool TimerWheel::cancel(int id) {
+    return deadlines.erase(id) > 0;
+}
+
+void TimerWheel::advance(long long now, vector<int>& fired) {
+    if (now - current > static_cast<long long>(kSlots) * kSlots) {
+        rebuild(now, fired);
+        return;
+    }
+    while (current < now) {
+        ++current;
+        // Сверху вниз: записи верхнего уровня могут попасть в ячейку
+        // нижнего, которая разбирается на этом же шаге.
+        for (int level = kLevels - 1; level > 0; --level) {
+            int shift = kSlotBits * level;
+            if ((current & ((1LL << shift) - 1)) != 0) {
+                continue;
+            }
+            if (level == kLevels - 1) {
+                cascade(overflow);
+            }
+            cascade(slots[level][(current >> shift) & (kSlots - 1)]);
+        }
+        fire(slots[0][current & (kSlots - 1)], fired);
+    }
+    fire(due, fired);
+}
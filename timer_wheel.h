@@ -0,0 +1,52 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+// Иерархическое колесо таймеров с шагом в минуту. Момент — минуты местного
+// времени от 01-01-1970 (см. toLocalInstant). Четыре уровня по 64 ячейки:
+// ячейка уровня k покрывает 64^k минут, всего около 30 лет вперёд; более
+// далёкие сроки лежат в отдельном списке. Запись переносится на уровень ниже
+// не более трёх раз, поэтому постановка и срабатывание — O(1) в среднем.
+// Отмена ленивая: запись с устаревшим сроком пропускается при срабатывании.
+class TimerWheel {
+private:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr int kSlots = 1 << kSlotBits;
+
+    struct Entry {
+        int id;
+        long long deadline;
+    };
+
+    std::vector<Entry> slots[kLevels][kSlots];
+    std::vector<Entry> overflow;
+    std::vector<Entry> due; // срок уже наступил, сработают при следующем advance
+    std::unordered_map<int, long long> deadlines; // действующий срок каждого ID
+    long long current;
+
+    void place(const Entry& entry);
+    void cascade(std::vector<Entry>& bucket);
+    void fire(std::vector<Entry>& bucket, std::vector<int>& fired);
+    void rebuild(long long now, std::vector<int>& fired);
+
+public:
+    explicit TimerWheel(long long _current);
+
+    // Повторная постановка того же ID заменяет прежний срок.
+    void schedule(int id, long long deadline);
+    bool cancel(int id);
+    bool contains(int id) const { return deadlines.count(id) > 0; }
+
+    // Сдвигает время до now и дописывает в fired ID со сроком не позже now.
+    void advance(long long now, std::vector<int>& fired);
+
+    long long now() const { return current; }
+    bool hasDue() const { return !due.empty(); }
+    std::size_t size() const { return deadlines.size(); }
+};
+
+#endif // TIMER_WHEEL_H
@@ -1,18 +1,24 @@
 #include "workstation.h"
 #include <iostream>
+#include <stdexcept>
+#include <type_traits>
 
-Workstation::Workstation(int _id, const std::string& _name, const std::string& _status)
+Workstation::Workstation(int _id, const std::string& _name, WorkstationStatus _status)
     : id(_id), name(_name), status(_status) {}
 
 void Workstation::display() const {
-    std::cout << "ID: " << id << ", Название: " << name << ", Статус: " << status << std::endl;
+    std::cout << "ID: " << id << ", Название: " << name << ", Статус: " << statusName(status) << std::endl;
 }
 
-void Workstation::updateStatus(const std::string& newStatus) {
+void Workstation::updateStatus(WorkstationStatus newStatus) {
+    if (!canTransition(status, newStatus)) {
+        throw std::runtime_error("Недопустимый переход статуса станции " + std::to_string(id) + ": "
+                                 + statusName(status) + " -> " + statusName(newStatus));
+    }
     status = newStatus;
 }
 
-SpecialWorkstation::SpecialWorkstation(int _id, const std::string& _name, const std::string& _status, int _rating)
+SpecialWorkstation::SpecialWorkstation(int _id, const std::string& _name, WorkstationStatus _status, int _rating)
     : Workstation(_id, _name, _status), performanceRating(_rating) {}
 
 void SpecialWorkstation::display() const {
@@ -21,6 +27,31 @@ void SpecialWorkstation::display() const {
 }
 
 std::ostream& operator<<(std::ostream& os, const Workstation& ws) {
-    os << "Рабочая станция [ID: " << ws.getId() << ", Название: " << ws.getName() << ", Статус: " << ws.getStatus() << "]";
+    os << "Рабочая станция [ID: " << ws.getId() << ", Название: " << ws.getName() << ", Статус: " << statusName(ws.getStatus()) << "]";
     return os;
 }
+
+Workstation& baseOf(AnyWorkstation& ws) {
+    return std::visit([](auto& concrete) -> Workstation& { return concrete; }, ws);
+}
+
+const Workstation& baseOf(const AnyWorkstation& ws) {
+    return std::visit([](const auto& concrete) -> const Workstation& { return concrete; }, ws);
+}
+
+int workstationId(const AnyWorkstation& ws) {
+    return baseOf(ws).getId();
+}
+
+WorkstationKind kindOf(const AnyWorkstation& ws) {
+    return std::visit([](const auto& concrete) { return std::decay_t<decltype(concrete)>::kKind; }, ws);
+}
+
+int ratingOf(const AnyWorkstation& ws) {
+    const SpecialWorkstation* special = std::get_if<SpecialWorkstation>(&ws);
+    return special ? special->getPerformanceRating() : 0;
+}
+
+void display(const AnyWorkstation& ws) {
+    std::visit([](const auto& concrete) { concrete.display(); }, ws);
+}
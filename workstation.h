@@ -1,38 +1,65 @@
 #ifndef WORKSTATION_H
 #define WORKSTATION_H
 
+#include <cstdint>
 #include <string>
 #include <iostream>
+#include <variant>
+#include "workstation_status.h"
+
+// Значения хранятся в столбце Workstations.kind.
+enum class WorkstationKind : std::uint8_t {
+    Standard = 0,
+    Premium = 1
+};
 
 class Workstation {
 protected:
     int id;
     std::string name;
-    std::string status;
+    WorkstationStatus status;
 
 public:
-    Workstation(int _id, const std::string& _name, const std::string& _status = "available");
-    virtual ~Workstation() = default;
+    static constexpr WorkstationKind kKind = WorkstationKind::Standard;
 
-    virtual void display() const;
-    virtual void updateStatus(const std::string& newStatus);
+    Workstation(int _id, const std::string& _name, WorkstationStatus _status = WorkstationStatus::Available);
+
+    void display() const;
+    // Бросает runtime_error, если переход запрещён таблицей kStatusTransitions.
+    void updateStatus(WorkstationStatus newStatus);
 
     int getId() const { return id; }
     std::string getName() const { return name; }
-    std::string getStatus() const { return status; }
+    WorkstationStatus getStatus() const { return status; }
 
     friend std::ostream& operator<<(std::ostream& os, const Workstation& ws);
 };
 
-class SpecialWorkstation : public Workstation {
+class SpecialWorkstation final : public Workstation {
 private:
     int performanceRating;
 
 public:
-    SpecialWorkstation(int _id, const std::string& _name, const std::string& _status, int _rating);
-    void display() const override;
+    static constexpr WorkstationKind kKind = WorkstationKind::Premium;
+
+    SpecialWorkstation(int _id, const std::string& _name, WorkstationStatus _status, int _rating);
+    void display() const;
+
+    int getPerformanceRating() const { return performanceRating; }
 };
 
 std::ostream& operator<<(std::ostream& os, const Workstation& ws);
 
+// Станция любого вида без срезки и без отдельного выделения памяти на объект.
+// Вызовы идут через std::visit по конкретному типу, а не через vtable.
+using AnyWorkstation = std::variant<Workstation, SpecialWorkstation>;
+
+Workstation& baseOf(AnyWorkstation& ws);
+const Workstation& baseOf(const AnyWorkstation& ws);
+int workstationId(const AnyWorkstation& ws);
+WorkstationKind kindOf(const AnyWorkstation& ws);
+// 0 для обычных станций.
+int ratingOf(const AnyWorkstation& ws);
+void display(const AnyWorkstation& ws);
+
 #endif // WORKSTATION_H
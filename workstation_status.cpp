@@ -0,0 +1,44 @@
+#include "workstation_status.h"
+
+using namespace std;
+
+bool parseStatus(string_view text, WorkstationStatus& status) {
+    for (int i = 0; i < kWorkstationStatusCount; ++i) {
+        WorkstationStatus candidate = static_cast<WorkstationStatus>(i);
+        if (text == statusName(candidate)) {
+            status = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool statusFromInt(int value, WorkstationStatus& status) {
+    if (value < 0 || value >= kWorkstationStatusCount) {
+        return false;
+    }
+    status = static_cast<WorkstationStatus>(value);
+    return true;
+}
+
+void WorkstationStatusIndex::insert(int id, WorkstationStatus status) {
+    ids[static_cast<int>(status)].insert(id);
+}
+
+void WorkstationStatusIndex::erase(int id, WorkstationStatus status) {
+    ids[static_cast<int>(status)].erase(id);
+}
+
+void WorkstationStatusIndex::move(int id, WorkstationStatus from, WorkstationStatus to) {
+    if (from == to) {
+        return;
+    }
+    ids[static_cast<int>(from)].erase(id);
+    ids[static_cast<int>(to)].insert(id);
+}
+
+void WorkstationStatusIndex::clear() {
+    for (auto& set : ids) {
+        set.clear();
+    }
+}
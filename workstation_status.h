@@ -0,0 +1,62 @@
+#ifndef WORKSTATION_STATUS_H
+#define WORKSTATION_STATUS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <unordered_set>
+
+// Значения хранятся в столбце Workstations.status — менять их нельзя.
+enum class WorkstationStatus : std::uint8_t {
+    Available = 0,
+    Booked = 1,
+    Maintenance = 2
+};
+
+constexpr int kWorkstationStatusCount = 3;
+
+constexpr const char* statusName(WorkstationStatus status) {
+    switch (status) {
+        case WorkstationStatus::Available: return "available";
+        case WorkstationStatus::Booked: return "booked";
+        case WorkstationStatus::Maintenance: return "maintenance";
+    }
+    return "unknown";
+}
+
+// Допустимые переходы [из][в]. Станцию на обслуживании нельзя сразу забронировать —
+// сначала её переводят в available.
+constexpr bool kStatusTransitions[kWorkstationStatusCount][kWorkstationStatusCount] = {
+    //                 available  booked  maintenance
+    /* available   */ { true,      true,   true  },
+    /* booked      */ { true,      true,   true  },
+    /* maintenance */ { true,      false,  true  },
+};
+
+constexpr bool canTransition(WorkstationStatus from, WorkstationStatus to) {
+    return kStatusTransitions[static_cast<int>(from)][static_cast<int>(to)];
+}
+
+static_assert(canTransition(WorkstationStatus::Available, WorkstationStatus::Booked), "available -> booked");
+static_assert(!canTransition(WorkstationStatus::Maintenance, WorkstationStatus::Booked), "maintenance -> booked");
+
+bool parseStatus(std::string_view text, WorkstationStatus& status);
+bool statusFromInt(int value, WorkstationStatus& status);
+
+// ID станций, разбитые по статусам: список станций с нужным статусом — O(результата),
+// их количество — O(1).
+class WorkstationStatusIndex {
+private:
+    std::unordered_set<int> ids[kWorkstationStatusCount];
+
+public:
+    void insert(int id, WorkstationStatus status);
+    void erase(int id, WorkstationStatus status);
+    void move(int id, WorkstationStatus from, WorkstationStatus to);
+    void clear();
+
+    const std::unordered_set<int>& idsWith(WorkstationStatus status) const { return ids[static_cast<int>(status)]; }
+    std::size_t count(WorkstationStatus status) const { return ids[static_cast<int>(status)].size(); }
+};
+
+#endif // WORKSTATION_STATUS_H
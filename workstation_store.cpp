@@ -0,0 +1,63 @@
+#include "workstation_store.h"
+
+using namespace std;
+
+void WorkstationStore::addPremium(int id, int rating) {
+    premiumPositions.insert(id, static_cast<uint32_t>(premiumIds.size()));
+    premiumIds.push_back(id);
+    premiumRatings.push_back(rating);
+}
+
+void WorkstationStore::erasePremium(int id) {
+    uint32_t pos;
+    if (!premiumPositions.find(id, pos)) {
+        return;
+    }
+    premiumPositions.erase(id);
+    uint32_t last = static_cast<uint32_t>(premiumIds.size() - 1);
+    if (pos != last) {
+        premiumIds[pos] = premiumIds[last];
+        premiumRatings[pos] = premiumRatings[last];
+        premiumPositions.erase(premiumIds[pos]);
+        premiumPositions.insert(premiumIds[pos], pos);
+    }
+    premiumIds.pop_back();
+    premiumRatings.pop_back();
+}
+
+Workstation* WorkstationStore::findBase(int id) {
+    AnyWorkstation* ws = items.find(id);
+    return ws ? &baseOf(*ws) : nullptr;
+}
+
+bool WorkstationStore::add(const AnyWorkstation& ws) {
+    if (!items.add(ws)) {
+        return false;
+    }
+    if (kindOf(ws) == WorkstationKind::Premium) {
+        addPremium(workstationId(ws), ratingOf(ws));
+    }
+    return true;
+}
+
+bool WorkstationStore::erase(int id) {
+    erasePremium(id);
+    return items.erase(id);
+}
+
+void WorkstationStore::clear() {
+    items.clear();
+    premiumIds.clear();
+    premiumRatings.clear();
+    premiumPositions.clear();
+}
+
+vector<int> WorkstationStore::premiumWithRatingAtLeast(int minRating) const {
+    vector<int> result;
+    for (size_t i = 0; i < premiumRatings.size(); ++i) {
+        if (premiumRatings[i] >= minRating) {
+            result.push_back(premiumIds[i]);
+        }
+    }
+    return result;
+}
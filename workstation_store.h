@@ -0,0 +1,46 @@
+#ifndef WORKSTATION_STORE_H
+#define WORKSTATION_STORE_H
+
+#include <cstddef>
+#include <vector>
+#include "workstation.h"
+#include "id_store.h"
+#include "id_hash_index.h"
+
+// Станции всех видов в одном хранилище со стабильными слотами (std::variant,
+// без срезки и без new на каждую станцию). Для премиум-станций дополнительно
+// ведутся плотные массивы ID и рейтингов: фильтр по рейтингу — проход по int.
+class WorkstationStore {
+private:
+    IdStore<AnyWorkstation, &workstationId> items;
+    std::vector<int> premiumIds;
+    std::vector<int> premiumRatings;
+    IdHashIndex premiumPositions; // ID -> позиция в premiumIds/premiumRatings
+
+    void addPremium(int id, int rating);
+    void erasePremium(int id);
+
+public:
+    using const_iterator = IdStore<AnyWorkstation, &workstationId>::const_iterator;
+
+    AnyWorkstation* find(int id) { return items.find(id); }
+    const AnyWorkstation* find(int id) const { return items.find(id); }
+    // Общая часть станции любого вида; nullptr, если станции нет.
+    Workstation* findBase(int id);
+    bool contains(int id) const { return items.contains(id); }
+
+    // false, если станция с таким ID уже есть.
+    bool add(const AnyWorkstation& ws);
+    bool erase(int id);
+    void clear();
+
+    std::size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    const_iterator begin() const { return items.begin(); }
+    const_iterator end() const { return items.end(); }
+
+    std::size_t premiumCount() const { return premiumIds.size(); }
+    std::vector<int> premiumWithRatingAtLeast(int minRating) const;
+};
+
+#endif // WORKSTATION_STORE_H
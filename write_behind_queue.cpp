@@ -0,0 +1,146 @@
+#include "write_behind_queue.h"
+#include "booking_manager.h"
+#include "booking.h"
+#include "workstation.h"
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+WriteBehindQueue::WriteBehindQueue(const StorageConfig& storage, const WriteBehindConfig& _config)
+    : manager(make_unique<BookingManager>(storage)), config(_config) {
+    if (config.maxBatchSize == 0) {
+        config.maxBatchSize = 1;
+    }
+    writer = thread(&WriteBehindQueue::run, this);
+}
+
+WriteBehindQueue::~WriteBehindQueue() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    wakeWriter.notify_one();
+    writer.join();
+}
+
+future<void> WriteBehindQueue::submit(Mutation mutation) {
+    Pending pending{ move(mutation), promise<void>() };
+    future<void> result = pending.done.get_future();
+    {
+        lock_guard<mutex> lock(queueMutex);
+        queue.push_back(move(pending));
+    }
+    wakeWriter.notify_one();
+    return result;
+}
+
+future<void> WriteBehindQueue::addWorkstation(const AnyWorkstation& ws) {
+    return submit([ws](BookingManager& m) { m.addWorkstation(ws); });
+}
+
+future<void> WriteBehindQueue::deleteWorkstation(int id) {
+    return submit([id](BookingManager& m) { m.deleteWorkstation(id); });
+}
+
+future<void> WriteBehindQueue::updateWorkstationStatus(int id, WorkstationStatus newStatus) {
+    return submit([id, newStatus](BookingManager& m) { m.updateWorkstationStatus(id, newStatus); });
+}
+
+future<void> WriteBehindQueue::addBooking(const Booking& b) {
+    return submit([b](BookingManager& m) { m.addBooking(b); });
+}
+
+future<void> WriteBehindQueue::deleteBooking(int bookingId) {
+    return submit([bookingId](BookingManager& m) { m.deleteBooking(bookingId); });
+}
+
+future<void> WriteBehindQueue::updateBooking(int bookingId, const Booking& b) {
+    return submit([bookingId, b](BookingManager& m) { m.updateBooking(bookingId, b); });
+}
+
+void WriteBehindQueue::flush() {
+    submit([](BookingManager&) {}).get();
+}
+
+WriteBehindStats WriteBehindQueue::getStats() const {
+    lock_guard<mutex> lock(queueMutex);
+    return stats;
+}
+
+void WriteBehindQueue::run() {
+    deque<Pending> batch;
+    unique_lock<mutex> lock(queueMutex);
+    while (true) {
+        wakeWriter.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+
+        // Первое изменение уже есть: ждём остальные не дольше maxDelay.
+        auto deadline = chrono::steady_clock::now() + config.maxDelay;
+        wakeWriter.wait_until(lock, deadline, [this] {
+            return stopping || queue.size() >= config.maxBatchSize;
+        });
+
+        while (!queue.empty() && batch.size() < config.maxBatchSize) {
+            batch.push_back(move(queue.front()));
+            queue.pop_front();
+        }
+
+        lock.unlock();
+        commitBatch(batch);
+        lock.lock();
+        batch.clear();
+    }
+}
+
+void WriteBehindQueue::commitBatch(deque<Pending>& batch) {
+    vector<exception_ptr> errors(batch.size());
+    size_t failed = 0;
+    try {
+        UnitOfWork work(*manager);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!manager->inTransaction()) {
+                // SQLite откатил всю пачку сам: без транзакции точки сохранения
+                // оставшихся изменений зафиксировались бы по одному.
+                errors[i] = make_exception_ptr(runtime_error("Пачка изменений отменена: транзакция откатилась"));
+                ++failed;
+                continue;
+            }
+            try {
+                UnitOfWork step(*manager);
+                batch[i].mutation(*manager);
+                step.commit();
+            } catch (...) {
+                errors[i] = current_exception();
+                ++failed;
+            }
+        }
+        work.commit();
+    } catch (...) {
+        exception_ptr batchError = current_exception();
+        for (auto& error : errors) {
+            if (!error) {
+                error = batchError;
+                ++failed;
+            }
+        }
+    }
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        ++stats.batches;
+        stats.mutations += batch.size();
+        stats.failedMutations += failed;
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (errors[i]) {
+            batch[i].done.set_exception(errors[i]);
+        } else {
+            batch[i].done.set_value();
+        }
+    }
+}
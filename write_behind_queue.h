@@ -0,0 +1,81 @@
+#ifndef WRITE_BEHIND_QUEUE_H
+#define WRITE_BEHIND_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "storage_config.h"
+#include "workstation.h"
+
+class BookingManager;
+class Booking;
+
+struct WriteBehindConfig {
+    std::size_t maxBatchSize = 256;
+    std::chrono::milliseconds maxDelay{ 2 };
+};
+
+struct WriteBehindStats {
+    std::size_t batches = 0;
+    std::size_t mutations = 0;
+    std::size_t failedMutations = 0;
+};
+
+// Асинхронная запись с групповой фиксацией. Фоновый поток владеет своим
+// соединением с базой, собирает изменения в пачки (до maxBatchSize или
+// maxDelay после первого изменения) и фиксирует пачку одной транзакцией.
+// Каждое изменение выполняется в своей точке сохранения: ошибка одного
+// изменения не отменяет остальные. Future завершается после COMMIT пачки;
+// насколько запись переживёт отключение питания, задаёт StorageConfig::synchronous.
+class WriteBehindQueue {
+public:
+    using Mutation = std::function<void(BookingManager&)>;
+
+private:
+    struct Pending {
+        Mutation mutation;
+        std::promise<void> done;
+    };
+
+    std::unique_ptr<BookingManager> manager;
+    WriteBehindConfig config;
+    mutable std::mutex queueMutex;
+    std::condition_variable wakeWriter;
+    std::deque<Pending> queue;
+    WriteBehindStats stats;
+    bool stopping = false;
+    std::thread writer;
+
+    void run();
+    void commitBatch(std::deque<Pending>& batch);
+
+public:
+    explicit WriteBehindQueue(const StorageConfig& storage = StorageConfig::durableFast(),
+                              const WriteBehindConfig& _config = WriteBehindConfig());
+    ~WriteBehindQueue();
+    WriteBehindQueue(const WriteBehindQueue&) = delete;
+    WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+    std::future<void> submit(Mutation mutation);
+
+    std::future<void> addWorkstation(const AnyWorkstation& ws);
+    std::future<void> deleteWorkstation(int id);
+    std::future<void> updateWorkstationStatus(int id, WorkstationStatus newStatus);
+    std::future<void> addBooking(const Booking& b);
+    std::future<void> deleteBooking(int bookingId);
+    std::future<void> updateBooking(int bookingId, const Booking& b);
+
+    // Ждёт, пока всё отправленное до этого вызова будет зафиксировано.
+    void flush();
+
+    WriteBehindStats getStats() const;
+};
+
+#endif // WRITE_BEHIND_QUEUE_H